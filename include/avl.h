@@ -8,6 +8,7 @@
 #define AVL_H
 
 #include <stddef.h> /* size_t */
+#include <stdint.h> /* uint32_t */
 
 /* handle for a AVL */
 typedef struct avl_s avl_t;
@@ -15,6 +16,39 @@ typedef struct avl_s avl_t;
 /* handle for a node */
 typedef struct node_s node_t;
 
+/* handle for a read-only frozen snapshot */
+typedef struct avl_frozen_s avl_frozen_t;
+
+/* upper bound on tree height: 1.44 * log2(n) for any n addressable by size_t */
+#define AVL_MAX_HEIGHT (96)
+
+/*
+    in-order iterator. Holds the path from the root to the current member,
+    so it can live on the caller's stack and needs no allocation.
+    Any AVLInsert or AVLRemove on the tree invalidates it; resume a paused
+    traversal with AVLIterSeek on the last data seen.
+*/
+typedef struct avl_iter_s
+{
+	const avl_t* tree;
+	node_t* path[AVL_MAX_HEIGHT];
+	size_t depth; /* 0 - end */
+} avl_iter_t;
+
+/*
+    counters kept by a tree when avl.c is compiled with -DAVL_STATS.
+    Comparisons count calls to the sorting method; descents the key prefix
+    decides are free. Without AVL_STATS nothing is counted or stored.
+*/
+typedef struct avl_stats_s
+{
+	size_t comparisons;
+	size_t single_rotations; /* outer cases of a rebalance */
+	size_t double_rotations; /* inner cases of a rebalance */
+	size_t allocations;      /* nodes handed out, copy-on-write copies too */
+	size_t find_depth[AVL_MAX_HEIGHT + 1]; /* lookups ending after d nodes */
+} avl_stats_t;
+
 /*
     sorting rule for the tree. Used instatus insert and find
 
@@ -44,6 +78,33 @@ typedef int (*avl_cmp_t)(const void* data, const void* tree_data);
 */
 typedef int (*avl_op_t)(void* tree_data, void* arg);
 
+/*
+    reduction function. Used in AVLParallelReduce
+    folds the part one task accumulated into the final result. Called on
+    the calling thread, once per task, in tree order
+
+    args:
+        arg: the argument given to AVLParallelReduce
+        part: the task's accumulator
+*/
+typedef void (*avl_reduce_t)(void* arg, void* part);
+
+/*
+    key prefix function. Used with AVLSetPrefix
+    maps data to a number kept inline in its node, so a descent can decide
+    most comparisons without dereferencing the data
+
+    args:
+        data: data to insert or find
+
+    returns:
+        a prefix that never contradicts the sorting method: whenever
+        prefix(a) < prefix(b), sorting_method(a, b) < 0. Equal keys must have
+        equal prefixes, or lookups miss them. e.g. for int keys
+        (uint32_t) *(int*) data ^ 0x80000000u, which decides every comparison
+*/
+typedef uint32_t (*avl_prefix_t)(const void* data);
+
 /*
     create a new tree
 
@@ -56,28 +117,168 @@ typedef int (*avl_op_t)(void* tree_data, void* arg);
 */
 avl_t* AVLCreate(avl_cmp_t sorting_method);
 
+/*
+    create a new tree whose nodes are carved from contiguous slab chunks.
+    removed nodes are recycled through a free list, and destroy frees whole
+    chunks instead of walking the tree
+
+    args:
+        sorting_method:
+        chunk_size: nodes per slab chunk, 0 for a default size
+
+    returns handle to new tree, NULL on failure
+
+    complexity O(1)
+*/
+avl_t* AVLCreateWithPool(avl_cmp_t sorting_method, size_t chunk_size);
+
+/*
+    create a new tree that readers may search from many threads while
+    AVLInsert and AVLRemove run. Updates copy the nodes they change and
+    publish a new root atomically, so readers never lock or wait; updates
+    are serialized on an internal mutex.
+
+    Safe from any thread at any time: AVLFind, AVLFindMany, AVLCount,
+    AVLIsEmpty, AVLHeight, AVLSelect, AVLRank, AVLLowerBound, AVLUpperBound,
+    AVLInsert, AVLRemove, AVLSynchronize, AVLSnapshot.
+    Everything else must not overlap an update.
+    Snapshots are supported as for AVLCreatePersistent.
+
+    Data removed from the tree may still be under comparison by a reader
+    until AVLSynchronize returns; only free it after that.
+
+    args:
+        sorting_method:
+
+    returns handle to new tree, NULL on failure
+
+    complexity O(1)
+*/
+avl_t* AVLCreateConcurrent(avl_cmp_t sorting_method);
+
+/*
+    create a new persistent tree. Updates copy the nodes on the path they
+    change instead of changing them in place, so AVLSnapshot can hand out
+    point-in-time views that share all unchanged nodes with the live tree.
+    Nodes are recycled once neither the tree nor any snapshot reaches them
+
+    args:
+        sorting_method:
+
+    returns handle to new tree, NULL on failure
+
+    complexity O(1)
+*/
+avl_t* AVLCreatePersistent(avl_cmp_t sorting_method);
+
+/*
+    takes a read-only point-in-time view of a persistent or concurrent tree.
+    The view is an ordinary avl_t for every query (find, foreach, iterators,
+    select, freeze...) and never sees later updates of the tree; AVLInsert
+    and AVLRemove on it fail. Release it with AVLDestroy, before destroying
+    the tree it was taken from
+
+    args:
+        tree - a avl_t handle from AVLCreatePersistent or AVLCreateConcurrent
+
+    returns handle to the snapshot, NULL on failure or for any other tree
+
+    complexity O(1)
+*/
+avl_t* AVLSnapshot(avl_t* tree);
+
+/*
+    create a perfectly balanced tree from items already sorted by
+    sorting_method. Nodes are laid out in one contiguous block, and the tree
+    uses a node pool like AVLCreateWithPool for later inserts
+
+    args:
+        sorting_method:
+        items - array of data in strictly ascending order
+        n - number of items
+
+    returns handle to new tree, NULL on failure or if items are not
+    strictly ascending
+
+    complexity O(n)
+*/
+avl_t* AVLBuildFromSorted(avl_cmp_t sorting_method, void** items, size_t n);
+
+/*
+    sets the key prefix of an empty tree. Comparisons look at the prefixes
+    kept in the nodes first and only call the sorting method when they tie
+
+    args:
+        tree - an empty avl_t handle, not a snapshot
+        prefix - order preserving prefix of the sorting method, NULL for none
+
+    returns:
+        0 on success, !0 if the tree isn't empty or is a snapshot
+
+    complexity O(1)
+*/
+int AVLSetPrefix(avl_t* tree, avl_prefix_t prefix);
+
+/*
+    prefix of a NUL terminated string ordered by strcmp: its first 4 bytes
+    big-endian. Can be passed to AVLSetPrefix
+
+    args:
+        data - a NUL terminated string
+
+    returns the prefix
+
+    complexity O(1)
+*/
+uint32_t AVLStringPrefix(const void* data);
+
+/*
+    reads the counters of a tree. Lookups by AVLFind, AVLFindAll and
+    AVLRemoveValue go into the depth histogram
+
+    args:
+        tree - a avl_t handle
+        stats - filled with the counters, zeroed if there are none
+
+    returns:
+        0 on success, !0 if the library was built without AVL_STATS
+
+    complexity O(1)
+*/
+int AVLGetStats(const avl_t* tree, avl_stats_t* stats);
+
+/*
+    zeroes the counters of a tree. Does nothing without AVL_STATS
+
+    args:
+        tree - a avl_t handle
+
+    complexity O(1)
+*/
+void AVLResetStats(avl_t* tree);
+
 /*
     TODO post order implementation
     destroy tree. free all related memory
 
     args:
         tree - a avl_t handle. Note: It is legal to destroy NULL.
+        Destroying a snapshot only releases the snapshot.
 
-    complexity O(n)
+    complexity O(n), O(chunks) for a tree created with AVLCreateWithPool
 */
 void AVLDestroy(avl_t* tree);
 
 /*
-    TODO pre order implementation
     counts members of tree
 
     args:
         tree - a avl_t handle
 
     return:
-        tree member count
+        tree member count, distinct keys for a multiset
 
-    complexity O(n)
+    complexity O(1)
 */
 size_t AVLCount(const avl_t* tree);
 
@@ -102,7 +303,8 @@ int AVLIsEmpty(const avl_t* tree);
         data - new member data
 
     return:
-      0 - success, !0 - failure;
+      0 - success, !0 - failure. In a multiset, data equal to a member is
+      added to that member's values
 
     complexity O(log(n))
 */
@@ -113,12 +315,57 @@ int AVLInsert(avl_t* tree, void* data);
 
     args:
         tree - a avl_t handle
-        data - member data
+        data - member data. In a multiset, all values of the key go
 
     complexity O(log(n))
 */
 void AVLRemove(avl_t* tree, const void* data);
 
+/*
+    delete one value from tree, the one stored as exactly data. In a
+    multiset, the key stays while it has other values
+
+    args:
+        tree - a avl_t handle
+        data - the pointer that was inserted
+
+    return:
+      0 - success, !0 - data isn't in the tree
+
+    complexity O(log(n) + values of the key)
+*/
+int AVLRemoveValue(avl_t* tree, const void* data);
+
+/*
+    turns an empty tree into a multiset: inserting data equal to a member
+    appends it to that member's values instead of failing. Every query that
+    returns one member (find, bounds, select, iterators, freeze) returns
+    the key's first value; AVLFindAll returns all of them and AVLForEach
+    visits all of them. Set operations are not supported on multisets
+
+    args:
+        tree - an empty avl_t handle, not persistent, concurrent or a snapshot
+
+    returns:
+        0 on success, !0 on failure
+
+    complexity O(1)
+*/
+int AVLSetMultiset(avl_t* tree);
+
+/*
+    waits until no reader can still see data removed before the call, and
+    recycles the nodes that held it, except those live snapshots still use.
+    No-op for a tree not created by AVLCreateConcurrent or
+    AVLCreatePersistent
+
+    args:
+        tree - a avl_t handle
+
+    complexity O(retired nodes), plus waiting for readers in progress
+*/
+void AVLSynchronize(avl_t* tree);
+
 /*
     TODO in order implementation
     performs an operation on tree,
@@ -135,6 +382,99 @@ void AVLRemove(avl_t* tree, const void* data);
 */
 int AVLForEach(avl_t* tree, avl_op_t operation, void* arg);
 
+/*
+    performs an operation on every member, on several threads at once.
+    The tree is cut into subtrees that the threads take turns on, stealing
+    from each other when they run out. Members of one subtree are visited in
+    order, but subtrees run in any order and at the same time, so operation
+    must be safe to call concurrently with the same arg. The tree must not
+    change meanwhile, unless it is concurrent
+
+    args:
+        tree - a avl_t handle
+        operation - function to be called. Must conform to avl_op_t
+        arg - optional additional arguments of operation
+        threads - threads to use, the caller included. 0 for one per CPU
+
+    returns:
+        0 on success, otherwise the result of an operation that failed.
+        A failure stops threads from taking further subtrees
+
+    complexity O(n / threads)
+*/
+int AVLParallelForEach(avl_t* tree, avl_op_t operation, void* arg,
+                       size_t threads);
+
+/*
+    like AVLParallelForEach, but every subtree gets a private zeroed part of
+    part_size bytes as the operation's arg. Once all are done, reduce folds
+    the parts into arg in tree order, so ordered results (exports,
+    checksums) come out as from a sequential AVLForEach
+
+    args:
+        tree - a avl_t handle
+        operation - called with each member and its subtree's part
+        part_size - bytes of each part
+        reduce - folds a part into arg. Must conform to avl_reduce_t
+        arg - passed to reduce
+        threads - threads to use, the caller included. 0 for one per CPU
+
+    returns:
+        0 on success, otherwise the result of an operation that failed, in
+        which case reduce is not called
+
+    complexity O(n / threads + tasks)
+*/
+int AVLParallelReduce(avl_t* tree, avl_op_t operation, size_t part_size,
+                      avl_reduce_t reduce, void* arg, size_t threads);
+
+/*
+    performs an operation, in order, on the members in [lo, hi] only.
+    subtrees outside the range are skipped
+
+    args:
+        tree - a avl_t handle
+        lo - smallest data to visit, need not be in the tree
+        hi - largest data to visit, need not be in the tree
+        operation - function to be called. Must conform to avl_op_t
+        arg - optional additional arguments of operation
+
+    returns:
+        0 on success, !0 on failure
+
+    complexity O(log(n) + k), k - number of members in range
+*/
+int AVLForEachRange(avl_t* tree, const void* lo, const void* hi,
+                    avl_op_t operation, void* arg);
+
+/*
+    finds the smallest member not less than data
+
+    args:
+        tree - a avl_t handle
+        data - data to compare with, need not be in the tree
+
+    returns:
+        pointer to data in the tree, NULL if every member is less than data
+
+    complexity O(log(n))
+*/
+void* AVLLowerBound(const avl_t* tree, const void* data);
+
+/*
+    finds the smallest member greater than data
+
+    args:
+        tree - a avl_t handle
+        data - data to compare with, need not be in the tree
+
+    returns:
+        pointer to data in the tree, NULL if no member is greater than data
+
+    complexity O(log(n))
+*/
+void* AVLUpperBound(const avl_t* tree, const void* data);
+
 /*
     searches the tree for a member by data
 
@@ -150,6 +490,41 @@ int AVLForEach(avl_t* tree, avl_op_t operation, void* arg);
 */
 void* AVLFind(const avl_t* tree, const void* data);
 
+/*
+    searches the tree for a key and returns all of its values at once
+
+    args:
+        tree - a avl_t handle
+        data - data to be found
+        values - set to the key's values in insertion order, NULL if not
+                 found. Valid until the next update of the tree
+
+    returns:
+        number of values, 0 if data doesn't exist. At most 1 unless the tree
+        is a multiset
+
+    complexity O(log(n))
+*/
+size_t AVLFindAll(const avl_t* tree, const void* data, void* const** values);
+
+/*
+    searches the tree for a batch of members. Lookups are advanced together
+    one level at a time, prefetching each next node, so the memory latency
+    of independent descents overlaps instead of adding up
+
+    args:
+        tree - a avl_t handle
+        keys - n data to be found
+        n - number of keys
+        out - receives n results, pointer to data in the tree or NULL
+
+    returns:
+        number of keys found
+
+    complexity O(n * log(m)), m - tree member count
+*/
+size_t AVLFindMany(const avl_t* tree, const void** keys, size_t n, void** out);
+
 /*
     returns height of current tree;
 
@@ -163,4 +538,299 @@ void* AVLFind(const avl_t* tree, const void* data);
 */
 size_t AVLHeight(const avl_t* tree);
 
+/*
+    positions iterator on the smallest member, or end if tree is empty
+
+    args:
+        tree - a avl_t handle
+        iter - iterator to initialize
+
+    complexity O(log(n))
+*/
+void AVLIterBegin(const avl_t* tree, avl_iter_t* iter);
+
+/*
+    positions iterator past the largest member
+
+    args:
+        tree - a avl_t handle
+        iter - iterator to initialize
+
+    complexity O(1)
+*/
+void AVLIterEnd(const avl_t* tree, avl_iter_t* iter);
+
+/*
+    positions iterator on the smallest member not less than data,
+    or end if there is none
+
+    args:
+        tree - a avl_t handle
+        data - data to compare with, need not be in the tree
+        iter - iterator to initialize
+
+    complexity O(log(n))
+*/
+void AVLIterSeek(const avl_t* tree, const void* data, avl_iter_t* iter);
+
+/*
+    advances iterator to the next member in order. Next of the largest
+    member is end, next of end stays end
+
+    args:
+        iter - a valid iterator
+
+    complexity amortized O(1)
+*/
+void AVLIterNext(avl_iter_t* iter);
+
+/*
+    moves iterator to the previous member in order. Previous of end is the
+    largest member, previous of the smallest member is end
+
+    args:
+        iter - a valid iterator
+
+    complexity amortized O(1)
+*/
+void AVLIterPrev(avl_iter_t* iter);
+
+/*
+    checks whether iterator is past the end
+
+    args:
+        iter - a valid iterator
+
+    return:
+        boolean
+
+    complexity O(1)
+*/
+int AVLIterIsEnd(const avl_iter_t* iter);
+
+/*
+    returns the member the iterator is positioned on
+
+    args:
+        iter - a valid iterator
+
+    returns:
+        pointer to data in the tree, NULL at end
+
+    complexity O(1)
+*/
+void* AVLIterGetData(const avl_iter_t* iter);
+
+/*
+    returns the k-th smallest member of the tree (order statistic)
+
+    args:
+        tree - a avl_t handle
+        k - zero based position in sorted order
+
+    returns:
+        pointer to data in the tree.
+        if k >= AVLCount(tree), returns NULL.
+
+    complexity O(log(n))
+*/
+void* AVLSelect(const avl_t* tree, size_t k);
+
+/*
+    returns the number of members that sort before data. If data is in the
+    tree this is its zero based position, so AVLSelect(tree, rank) finds it
+
+    args:
+        tree - a avl_t handle
+        data - data to be ranked, need not be in the tree
+
+    returns:
+        count of members smaller than data
+
+    complexity O(log(n))
+*/
+size_t AVLRank(const avl_t* tree, const void* data);
+
+/*
+    adds to dest every member of src it doesn't have yet. Runs as a join
+    based union: dest is split around src's members and glued back, so only
+    O(m * log(n / m + 1)) work is done for m = AVLCount(src) <= n.
+    src is only read; new nodes come from dest's allocator
+
+    args:
+        dest - a avl_t handle, not persistent, concurrent or a snapshot
+        src - a avl_t handle with the same sorting method
+
+    returns:
+        0 on success, !0 on failure. If a node allocation fails, dest keeps
+        everything else of the union
+
+    complexity O(m * log(n / m + 1))
+*/
+int AVLUnion(avl_t* dest, const avl_t* src);
+
+/*
+    keeps only the members of dest that src has too. src is only read
+
+    args:
+        dest - a avl_t handle, not persistent, concurrent or a snapshot
+        src - a avl_t handle with the same sorting method
+
+    returns:
+        0 on success, !0 on failure
+
+    complexity O(m * log(n / m + 1))
+*/
+int AVLIntersect(avl_t* dest, const avl_t* src);
+
+/*
+    removes from dest every member src has. src is only read
+
+    args:
+        dest - a avl_t handle, not persistent, concurrent or a snapshot
+        src - a avl_t handle with the same sorting method
+
+    returns:
+        0 on success, !0 on failure
+
+    complexity O(m * log(n / m + 1))
+*/
+int AVLDifference(avl_t* dest, const avl_t* src);
+
+/*
+    moves every member greater than data out of tree into a new tree.
+    tree keeps the members not greater than data
+
+    args:
+        tree - a avl_t handle from AVLCreate
+        data - split point, need not be in the tree
+
+    returns:
+        handle to a new tree with the greater members, NULL on failure or
+        for a pooled, persistent or concurrent tree or a snapshot
+
+    complexity O(log(n))
+*/
+avl_t* AVLSplit(avl_t* tree, const void* data);
+
+/*
+    moves every member of right into left. All members of left must be
+    smaller than all members of right; right is left empty
+
+    args:
+        left - a avl_t handle, not persistent, concurrent or a snapshot
+        right - a avl_t handle, created the same way as left (both by
+                AVLCreate, or both with a node pool)
+
+    returns:
+        0 on success, !0 on failure or if the trees overlap
+
+    complexity O(log(n)), plus O(chunks) for pooled trees
+*/
+int AVLJoin(avl_t* left, avl_t* right);
+
+/*
+    creates an immutable snapshot of the tree, laid out in one array in
+    Eytzinger (breadth first) order. Searches on the snapshot walk the array
+    without pointer chasing and prefetch the levels ahead. The snapshot
+    shares data pointers with the tree but not nodes, so the tree may change
+    or be destroyed afterwards
+
+    args:
+        tree - a avl_t handle
+
+    returns:
+        handle to new snapshot, NULL on failure
+
+    complexity O(n)
+*/
+avl_frozen_t* AVLFreeze(const avl_t* tree);
+
+/*
+    destroy snapshot. Note: It is legal to destroy NULL.
+
+    args:
+        frozen - a avl_frozen_t handle
+
+    complexity O(1)
+*/
+void AVLFrozenDestroy(avl_frozen_t* frozen);
+
+/*
+    counts members of snapshot
+
+    args:
+        frozen - a avl_frozen_t handle
+
+    return:
+        snapshot member count
+
+    complexity O(1)
+*/
+size_t AVLFrozenCount(const avl_frozen_t* frozen);
+
+/*
+    searches the snapshot for a member by data
+
+    args:
+        frozen - a avl_frozen_t handle
+        data - data to be found
+
+    returns:
+        pointer to data in the snapshot.
+        if data doesn't exist, returns NULL.
+
+    complexity O(log(n))
+*/
+void* AVLFrozenFind(const avl_frozen_t* frozen, const void* data);
+
+/*
+    finds the smallest snapshot member not less than data
+
+    args:
+        frozen - a avl_frozen_t handle
+        data - data to compare with, need not be in the snapshot
+
+    returns:
+        pointer to data in the snapshot, NULL if every member is less
+
+    complexity O(log(n))
+*/
+void* AVLFrozenLowerBound(const avl_frozen_t* frozen, const void* data);
+
+/*
+    writes the tree to a file, each member copied as a record of
+    record_size bytes in the order of a frozen snapshot. The members must
+    not hold pointers, and the file is only readable on hosts with the
+    same byte order
+
+    args:
+        tree - a avl_t handle
+        path - file to create or overwrite
+        record_size - bytes to copy from each member's data
+
+    returns:
+        0 on success, !0 on failure
+
+    complexity O(n)
+*/
+int AVLSave(const avl_t* tree, const char* path, size_t record_size);
+
+/*
+    maps a file written by AVLSave as a read-only frozen snapshot. Nothing
+    is read up front: searches run on the mapped records directly, and
+    pages load as they are touched. Returned data points into the mapping,
+    which is read-only and goes with AVLFrozenDestroy
+
+    args:
+        path - file written by AVLSave
+        sorting_method - the sorting method of the saved tree
+
+    returns:
+        handle to new snapshot, NULL on failure or if the file is not valid
+
+    complexity O(1)
+*/
+avl_frozen_t* AVLLoad(const char* path, avl_cmp_t sorting_method);
+
 #endif /* AVL_H */
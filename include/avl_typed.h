@@ -0,0 +1,277 @@
+/*****************************************
+ * date: Tue Jun 17 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: John Doe               *
+ *****************************************/
+
+#ifndef AVL_TYPED_H
+#define AVL_TYPED_H
+
+#include <stddef.h> /* size_t */
+#include <stdlib.h> /* malloc, free */
+
+#include "avl.h" /* AVL_MAX_HEIGHT */
+
+/*
+    AVL tree specialized for one key type. Keys are stored by value in the
+    nodes and compared by cmp directly, so the compiler can inline it into
+    every descent instead of calling through an avl_cmp_t.
+
+    AVL_DEFINE(name, type, cmp) defines, as static inline functions:
+
+        name##_t* name##Create(void)
+        void name##Destroy(name##_t* tree)
+        int name##Insert(name##_t* tree, type key)
+            0 on success, !0 if key is already in the tree or on failure
+        void name##Remove(name##_t* tree, type key)
+        type* name##Find(const name##_t* tree, type key)
+            the stored key, NULL if not found. Fields cmp doesn't look at may
+            be changed through it
+        size_t name##Count(const name##_t* tree)
+        int name##IsEmpty(const name##_t* tree)
+        size_t name##Height(const name##_t* tree)
+        int name##ForEach(name##_t* tree, int (*op)(type*, void*), void* arg)
+            in order, stops at the first op that returns !0 and returns it
+
+    args:
+        name - prefix of the generated type and functions
+        type - key type, copied by assignment
+        cmp - function or macro, cmp(a, b) is negative, 0 or positive as
+              a sorts before, equal to or after b
+
+    e.g.
+        AVL_DEFINE(IntAVL, int, AVL_NUMERIC_CMP)
+        IntAVL_t* tree = IntAVLCreate();
+        IntAVLInsert(tree, 42);
+
+    complexity as the matching avl.h functions
+*/
+#define AVL_DEFINE(name, type, cmp)                                            \
+	typedef struct name##_node_s name##_node_t;                                \
+	struct name##_node_s                                                       \
+	{                                                                          \
+		name##_node_t* side[2];                                                \
+		type key;                                                              \
+		unsigned char height;                                                  \
+	};                                                                         \
+                                                                               \
+	typedef struct name##_s                                                    \
+	{                                                                          \
+		name##_node_t* root;                                                   \
+		size_t count;                                                          \
+	} name##_t;                                                                \
+                                                                               \
+	/* ---- helpers ---- */                                                   \
+                                                                               \
+	static inline size_t name##_Height(const name##_node_t* node)              \
+	{                                                                          \
+		return node ? node->height : 0;                                        \
+	}                                                                          \
+                                                                               \
+	static inline void name##_UpdateHeight(name##_node_t* node)                \
+	{                                                                          \
+		size_t lh = name##_Height(node->side[0]);                              \
+		size_t rh = name##_Height(node->side[1]);                              \
+		node->height = (unsigned char) ((lh > rh ? lh : rh) + 1);              \
+	}                                                                          \
+                                                                               \
+	/* right height - left height */                                           \
+	static inline int name##_Balance(const name##_node_t* node)                \
+	{                                                                          \
+		return (int) name##_Height(node->side[1]) -                            \
+		       (int) name##_Height(node->side[0]);                             \
+	}                                                                          \
+                                                                               \
+	/* dir 0 rotates left (right child rises), dir 1 rotates right */          \
+	static inline name##_node_t* name##_Rotate(name##_node_t* root, int dir)   \
+	{                                                                          \
+		name##_node_t* pivot = root->side[!dir];                               \
+		root->side[!dir] = pivot->side[dir];                                   \
+		pivot->side[dir] = root;                                               \
+		name##_UpdateHeight(root);                                             \
+		name##_UpdateHeight(pivot);                                            \
+		return pivot;                                                          \
+	}                                                                          \
+                                                                               \
+	static inline name##_node_t* name##_Rebalance(name##_node_t* node)         \
+	{                                                                          \
+		int bf = 0;                                                            \
+		name##_UpdateHeight(node);                                             \
+		bf = name##_Balance(node);                                             \
+		if (bf > 1)                                                            \
+		{                                                                      \
+			if (name##_Balance(node->side[1]) < 0)                             \
+				node->side[1] = name##_Rotate(node->side[1], 1);               \
+			return name##_Rotate(node, 0);                                     \
+		}                                                                      \
+		if (bf < -1)                                                           \
+		{                                                                      \
+			if (name##_Balance(node->side[0]) > 0)                             \
+				node->side[0] = name##_Rotate(node->side[0], 0);               \
+			return name##_Rotate(node, 1);                                     \
+		}                                                                      \
+		return node;                                                           \
+	}                                                                          \
+                                                                               \
+	/* rebalance the recorded path bottom-up until a height stops changing */ \
+	static inline void name##_Retrace(name##_node_t** path[], size_t depth)    \
+	{                                                                          \
+		name##_node_t* node = NULL;                                            \
+		size_t old_height = 0;                                                 \
+		while (depth > 0)                                                      \
+		{                                                                      \
+			node = *path[--depth];                                             \
+			old_height = node->height;                                         \
+			*path[depth] = name##_Rebalance(node);                             \
+			if ((*path[depth])->height == old_height)                          \
+				break;                                                         \
+		}                                                                      \
+	}                                                                          \
+                                                                               \
+	static inline void name##_DestroyRec(name##_node_t* node)                  \
+	{                                                                          \
+		if (!node)                                                             \
+			return;                                                            \
+		name##_DestroyRec(node->side[0]);                                      \
+		name##_DestroyRec(node->side[1]);                                      \
+		free(node);                                                            \
+	}                                                                          \
+                                                                               \
+	static inline int name##_ForEachRec(name##_node_t* node,                   \
+	                                    int (*op)(type*, void*), void* arg)    \
+	{                                                                          \
+		int status = 0;                                                        \
+		if (!node)                                                             \
+			return 0;                                                          \
+		status = name##_ForEachRec(node->side[0], op, arg);                    \
+		if (status)                                                            \
+			return status;                                                     \
+		status = op(&node->key, arg);                                          \
+		if (status)                                                            \
+			return status;                                                     \
+		return name##_ForEachRec(node->side[1], op, arg);                      \
+	}                                                                          \
+                                                                               \
+	/* ---- API ---- */                                                       \
+                                                                               \
+	static inline name##_t* name##Create(void)                                 \
+	{                                                                          \
+		name##_t* tree = malloc(sizeof(name##_t));                             \
+		if (!tree)                                                             \
+			return NULL;                                                       \
+		tree->root = NULL;                                                     \
+		tree->count = 0;                                                       \
+		return tree;                                                           \
+	}                                                                          \
+                                                                               \
+	static inline void name##Destroy(name##_t* tree)                           \
+	{                                                                          \
+		if (!tree)                                                             \
+			return;                                                            \
+		name##_DestroyRec(tree->root);                                         \
+		free(tree);                                                            \
+	}                                                                          \
+                                                                               \
+	static inline int name##Insert(name##_t* tree, type key)                   \
+	{                                                                          \
+		name##_node_t** path[AVL_MAX_HEIGHT];                                  \
+		name##_node_t** link = &tree->root;                                    \
+		name##_node_t* node = NULL;                                            \
+		size_t depth = 0;                                                      \
+		int cmp_res = 0;                                                       \
+		while (*link)                                                          \
+		{                                                                      \
+			cmp_res = cmp(key, (*link)->key);                                  \
+			if (cmp_res == 0)                                                  \
+				return -1; /* duplicates not supported */                      \
+			path[depth++] = link;                                              \
+			link = &(*link)->side[cmp_res > 0];                                \
+		}                                                                      \
+		node = malloc(sizeof(name##_node_t));                                  \
+		if (!node)                                                             \
+			return -1;                                                         \
+		node->side[0] = node->side[1] = NULL;                                  \
+		node->key = key;                                                       \
+		node->height = 1;                                                      \
+		*link = node;                                                          \
+		++tree->count;                                                         \
+		name##_Retrace(path, depth);                                           \
+		return 0;                                                              \
+	}                                                                          \
+                                                                               \
+	static inline void name##Remove(name##_t* tree, type key)                  \
+	{                                                                          \
+		name##_node_t** path[AVL_MAX_HEIGHT];                                  \
+		name##_node_t** link = &tree->root;                                    \
+		name##_node_t* node = NULL;                                            \
+		size_t depth = 0;                                                      \
+		int cmp_res = 0;                                                       \
+		while (*link)                                                          \
+		{                                                                      \
+			cmp_res = cmp(key, (*link)->key);                                  \
+			if (cmp_res == 0)                                                  \
+				break;                                                         \
+			path[depth++] = link;                                              \
+			link = &(*link)->side[cmp_res > 0];                                \
+		}                                                                      \
+		if (!*link)                                                            \
+			return;                                                            \
+		node = *link;                                                          \
+		if (node->side[0] && node->side[1])                                    \
+		{                                                                      \
+			/* take the successor's key and unlink the successor instead */    \
+			path[depth++] = link;                                              \
+			link = &node->side[1];                                             \
+			while ((*link)->side[0])                                           \
+			{                                                                  \
+				path[depth++] = link;                                          \
+				link = &(*link)->side[0];                                      \
+			}                                                                  \
+			node->key = (*link)->key;                                          \
+			node = *link;                                                      \
+		}                                                                      \
+		*link = node->side[!node->side[0]];                                    \
+		free(node);                                                            \
+		--tree->count;                                                         \
+		name##_Retrace(path, depth);                                           \
+	}                                                                          \
+                                                                               \
+	static inline type* name##Find(const name##_t* tree, type key)             \
+	{                                                                          \
+		name##_node_t* node = tree->root;                                      \
+		int cmp_res = 0;                                                       \
+		while (node)                                                           \
+		{                                                                      \
+			cmp_res = cmp(key, node->key);                                     \
+			if (cmp_res == 0)                                                  \
+				return &node->key;                                             \
+			node = node->side[cmp_res > 0];                                    \
+		}                                                                      \
+		return NULL;                                                           \
+	}                                                                          \
+                                                                               \
+	static inline size_t name##Count(const name##_t* tree)                     \
+	{                                                                          \
+		return tree->count;                                                    \
+	}                                                                          \
+                                                                               \
+	static inline int name##IsEmpty(const name##_t* tree)                      \
+	{                                                                          \
+		return tree->root == NULL;                                             \
+	}                                                                          \
+                                                                               \
+	static inline size_t name##Height(const name##_t* tree)                    \
+	{                                                                          \
+		return name##_Height(tree->root);                                      \
+	}                                                                          \
+                                                                               \
+	static inline int name##ForEach(name##_t* tree, int (*op)(type*, void*),   \
+	                                void* arg)                                 \
+	{                                                                          \
+		return name##_ForEachRec(tree->root, op, arg);                         \
+	}
+
+/* three-way compare for any type with < and >, usable as AVL_DEFINE's cmp */
+#define AVL_NUMERIC_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+
+#endif /* AVL_TYPED_H */
@@ -12,23 +12,51 @@
 #define TABLE_SIZE 100
 #define MAX_WORD_SIZE 100
 #define AMOUNT_OF_WORDS 104334
+#define HASH_HISTOGRAM_SIZE 16
 
-typedef struct list list_t;
-typedef struct node node_t;
 typedef struct hash_table hash_table_t;
+typedef struct dictionary dictionary_t;
 
 typedef int (*cmp_func_t)(const void* data, const void* key);
 typedef size_t (*hash_func_t)(const void* key);
 typedef int (*Action)(void* data, void* params);
 
+/* Shape of the lists, as reported by HashStats */
+typedef struct hash_stats
+{
+	size_t lists;       /* Lists counted, old and new during a resize */
+	size_t elements;    /* Elements in them */
+	size_t empty;       /* Lists with no element */
+	size_t max_length;  /* Elements in the longest list */
+	double average;     /* elements / lists */
+	double sd;          /* Standard deviation of the list lengths */
+	double empty_ratio; /* empty / lists */
+	size_t histogram[HASH_HISTOGRAM_SIZE]; /* histogram[i] - lists of i
+	                                          elements, the last one also
+	                                          counts all longer lists */
+} hash_stats_t;
+
 /* Create the hash hashTable.
 Return value: a pointer to the hashTable.
 cmp_func_t != NULL
 key != NULL
-hashTableSz > 0 */
+hashTableSz > 0. Lists are picked by hash modulo hashTableSz. */
 hash_table_t* Create(cmp_func_t cmp_func /*1 = TRUE  0 = FALSE*/,
                      hash_func_t hash_func, size_t hashTableSz);
 
+/* Create the hash hashTable in power of 2 mode: hashTableSz is rounded up to
+a power of 2, growth and shrinking keep it one, and lists are picked by
+Fibonacci multiply-shift instead of modulo. That is cheaper than a division
+and spreads hashes whose low bits repeat, like an identity hash of strided
+keys, but spreads multiplicative hashes such as x * 31 + c worse than
+modulo. Use it with the hash functions of hash_funcs.h.
+Return value: a pointer to the hashTable, NULL on failure.
+cmp_func != NULL
+hash_func != NULL
+hashTableSz > 0 */
+hash_table_t* CreatePow2(cmp_func_t cmp_func, hash_func_t hash_func,
+                         size_t hashTableSz);
+
 /* Destroy the hashTable.
 Note: It is legal to destroy NULL. */
 void Destroy(hash_table_t* hashTable);
@@ -76,13 +104,69 @@ Return value: HashSize / hashTableSz
 hashTable != NULL */
 double Load(const hash_table_t* hashTable);
 
+/* Let the hashTable resize itself as its load changes. After an Insert that
+takes Load() above max_load the number of lists doubles, after a Remove that
+takes it below min_load it halves, never below the size given to Create.
+The elements move over a few lists at a time on the following Inserts and
+Removes, with Find and Foreach looking at both arrays meanwhile, so no single
+call pays for the whole table.
+0 turns a direction off; both are off after Create.
+hashTable != NULL
+max_load == 0 or min_load < max_load / 2, so a resize can't undo the last */
+void SetLoadLimits(hash_table_t* hashTable, double max_load, double min_load);
+
+/* Move every element into newSize lists. Entries are relinked, not copied.
+Return value: 0 - for success, 1 - for failure (hashTable unchanged)
+hashTable != NULL
+newSize > 0
+O(n + newSize) */
+int Rehash(hash_table_t* hashTable, size_t newSize);
+
+/* Move up to steps more lists of a resize in progress, e.g. while idle.
+Return value: 1 if lists are left to move, 0 if no resize is in progress
+hashTable != NULL
+O(steps) lists */
+int RehashStep(hash_table_t* hashTable, size_t steps);
+
 /* Calculate standard error.
 Return value: STD / HashSize
 STD = root of: (sum of every element - average) / HashSize.
-hashTable != NULL */
+hashTable != NULL
+O(hashTableSz) */
+double SD(const hash_table_t* hashTable);
+
+/* Report the list length histogram, longest list, standard deviation and
+share of empty lists. Every list keeps its length up to date on Insert and
+Remove, so no list is walked.
+hashTable != NULL
+stats != NULL
+O(hashTableSz) */
+void HashStats(const hash_table_t* hashTable, hash_stats_t* stats);
 
 /*--------------------------Helper funcs--------------------------*/
 
 void LoadDic(hash_table_t* hash_table);
 
+/* Insert every word of a text file, one per line, into the hashTable. The
+file is mapped rather than read, and the words are NUL terminated in place,
+so there is no allocation per word beyond the table's own entry. Lines are
+split with memchr, the hashTable grows once to fit them all, and with
+threads > 1 the words are hashed in parallel before being linked in.
+That growth doubles the lists until the load is at most 1, whatever
+SetLoadLimits says, so it also grows a hashTable whose growth is off.
+Empty lines are skipped and a '\r' before a newline is dropped.
+Return value: the mapped words, NULL on failure, including failing to grow
+(hashTable unchanged).
+hash_table != NULL
+path != NULL
+threads - threads to hash on, 0 or 1 for the calling thread only
+O(file size + words / threads) */
+dictionary_t* LoadDicFile(hash_table_t* hash_table, const char* path,
+                          size_t threads);
+
+/* Unmap the words of LoadDicFile. Remove them from the hashTable, or
+destroy it, first.
+Note: It is legal to free NULL. */
+void FreeDic(dictionary_t* dictionary);
+
 #endif /* C_HASH_TABLE_H */
@@ -0,0 +1,94 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+#ifndef CONCURRENT_HASH_TABLE_H
+#define CONCURRENT_HASH_TABLE_H
+
+#include <stddef.h> /* size_t */
+
+#include "c_hash_table.h" /* cmp_func_t, hash_func_t, Action */
+
+/* Chained hash table for many threads at once. Find, Foreach, Size, IsEmpty
+and Load never lock or wait: readers only announce themselves in an epoch
+counter. Insert and Remove lock one of a fixed set of stripes, each owning a
+contiguous range of lists, so writers to different ranges run in parallel.
+The number of lists is a power of 2 and doubles once a range averages more
+than one element per list; readers keep using the old lists until the new
+ones are published. Same contract as c_hash_table.h: cmp_func returns 1 on
+a match and duplicates are allowed.
+
+Data removed from the table may still be under comparison by a reader until
+ConcurrentHashSynchronize returns; only free it after that. */
+typedef struct concurrent_hash_table concurrent_hash_table_t;
+
+/* Create the hashTable.
+Return value: a pointer to the hashTable, NULL on failure.
+cmp_func != NULL
+hash_func != NULL
+capacity - initial number of lists, rounded up to a power of 2 and to at
+least one per stripe. 0 for that minimum */
+concurrent_hash_table_t* ConcurrentHashCreate(cmp_func_t cmp_func,
+                                              hash_func_t hash_func,
+                                              size_t capacity);
+
+/* Destroy the hashTable. No other call may overlap it.
+Note: It is legal to destroy NULL. */
+void ConcurrentHashDestroy(concurrent_hash_table_t* hashTable);
+
+/* Insert data to the hashTable.
+Return value: 0 - for successful insertion, 1 - for failure
+hashTable != NULL
+data != NULL
+Average O(1), amortized over growth */
+int ConcurrentHashInsert(concurrent_hash_table_t* hashTable, void* data);
+
+/* Remove the key from the hashTable.
+Return value: the removed data, NULL if key wasn't found. Of several threads
+removing the same key only one gets it.
+hashTable != NULL
+key != NULL
+Average O(1)*/
+void* ConcurrentHashRemove(concurrent_hash_table_t* hashTable,
+                           const void* key);
+
+/* Find the key in the hashTable.
+Return value: data if found, NULL else.
+hashTable != NULL
+key != NULL
+Average O(1)*/
+void* ConcurrentHashFind(const concurrent_hash_table_t* hashTable,
+                         const void* key);
+
+/* Number of elements in the hashTable, as of some moment during the call.
+hashTable != NULL */
+size_t ConcurrentHashSize(const concurrent_hash_table_t* hashTable);
+
+/* Check if the hashTable is empty.
+Return value: 1 if empty, 0 else
+hashTable != NULL */
+int ConcurrentHashIsEmpty(const concurrent_hash_table_t* hashTable);
+
+/* Perform the action function on each element in the hashTable. Elements
+inserted or removed during the call may or may not be visited. action runs
+as a reader, so it must not Insert, Remove or Synchronize on hashTable.
+Return value: 0 if OK for all, else the first non zero action result
+hashTable != NULL
+action != NULL */
+int ConcurrentHashForeach(const concurrent_hash_table_t* hashTable,
+                          Action action, void* params);
+
+/* Calculate the load on the hashTable.
+Return value: elements / lists
+hashTable != NULL */
+double ConcurrentHashLoad(const concurrent_hash_table_t* hashTable);
+
+/* Wait until no reader can still see data removed before the call, and free
+the entries that held it.
+hashTable != NULL
+O(removed entries), plus waiting for readers in progress */
+void ConcurrentHashSynchronize(concurrent_hash_table_t* hashTable);
+
+#endif /* CONCURRENT_HASH_TABLE_H */
@@ -0,0 +1,46 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+#ifndef HASH_FUNCS_H
+#define HASH_FUNCS_H
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+
+/* Ready made hash functions for c_hash_table.h and open_hash_table.h. All of
+them mix every input bit into every output bit, so keys that differ only in
+high bits, or that share a stride, still land in different lists. Results
+are 64 bit and depend on byte order, so don't store them across machines. */
+
+/* Finalize a 64 bit integer (splitmix64). A bijection, so distinct integers
+never collide before the table reduces them.
+O(1) */
+size_t HashU64(uint64_t value);
+
+/* hash_func_t for keys pointing at an int.
+key != NULL
+O(1) */
+size_t HashInt(const void* key);
+
+/* hash_func_t hashing the pointer itself, for sets of objects compared by
+address.
+O(1) */
+size_t HashPtr(const void* key);
+
+/* Hash len bytes from data, in the style of wyhash: 16 bytes per 128 bit
+multiply, 48 per loop on long inputs.
+data != NULL or len == 0
+seed - any value, different seeds give unrelated functions
+O(len) */
+size_t HashBytes(const void* data, size_t len, uint64_t seed);
+
+/* hash_func_t for keys pointing at a NUL terminated string, HashBytes of
+its characters with seed 0.
+key != NULL
+O(length) */
+size_t HashStr(const void* key);
+
+#endif /* HASH_FUNCS_H */
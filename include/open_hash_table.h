@@ -0,0 +1,77 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+#ifndef OPEN_HASH_TABLE_H
+#define OPEN_HASH_TABLE_H
+
+#include <stddef.h> /* size_t */
+
+#include "c_hash_table.h" /* cmp_func_t, hash_func_t, Action */
+
+/* Open addressing hash table with Robin Hood probing. Elements live in one
+flat array of slots, with a byte of probe distance per slot kept apart so a
+probe scans a cache line of them at once. Each slot keeps its element's
+hash next to it, so a hit reads one slot record after the distance bytes,
+growing never calls hash_func, and cmp_func only runs on a hash match. No
+allocation per element; the array doubles when it gets too full. Same contract as c_hash_table.h:
+cmp_func returns 1 on a match and duplicates are allowed. */
+typedef struct open_hash_table open_hash_table_t;
+
+/* Create the hashTable.
+Return value: a pointer to the hashTable, NULL on failure.
+cmp_func != NULL
+hash_func != NULL
+capacity - initial number of slots, rounded up to a power of 2. 0 for a
+default */
+open_hash_table_t* OpenHashCreate(cmp_func_t cmp_func, hash_func_t hash_func,
+                                  size_t capacity);
+
+/* Destroy the hashTable.
+Note: It is legal to destroy NULL. */
+void OpenHashDestroy(open_hash_table_t* hashTable);
+
+/* Insert data to the hashTable.
+Return value: 0 - for successful insertion, 1 - for failure
+hashTable != NULL
+data != NULL
+Average O(1), amortized over growth */
+int OpenHashInsert(open_hash_table_t* hashTable, void* data);
+
+/* Remove the key from the hashTable.
+hashTable != NULL
+key != NULL
+Average O(1)*/
+void OpenHashRemove(open_hash_table_t* hashTable, const void* key);
+
+/* Find the key in the hashTable.
+Return value: data if found, NULL else.
+hashTable != NULL
+key != NULL
+Average O(1)*/
+void* OpenHashFind(const open_hash_table_t* hashTable, const void* key);
+
+/* Number of elements in the hashTable.
+hashTable != NULL */
+size_t OpenHashSize(const open_hash_table_t* hashTable);
+
+/* Check if the hashTable is empty.
+Return value: 1 if empty, 0 else
+hashTable != NULL */
+int OpenHashIsEmpty(const open_hash_table_t* hashTable);
+
+/* Perform the action function on each element in the hashTable.
+Return value: 0 if OK for all, else the first non zero action result
+hashTable != NULL
+action != NULL */
+int OpenHashForeach(const open_hash_table_t* hashTable, Action action,
+                    void* params);
+
+/* Calculate the load on the hashTable.
+Return value: elements / slots
+hashTable != NULL */
+double OpenHashLoad(const open_hash_table_t* hashTable);
+
+#endif /* OPEN_HASH_TABLE_H */
@@ -4,40 +4,285 @@
  * code reviewer: John Doe               *
  *****************************************/
 
-#include <stdlib.h> /* malloc, free */
-#include <assert.h> /* assert */
+#include <stdlib.h>   /* malloc, calloc, realloc, free */
+#include <string.h>   /* memcmp, memcpy, memset */
+#include <stdio.h>    /* FILE, fopen, fwrite, fclose */
+#include <assert.h>   /* assert */
+#include <pthread.h>  /* pthread_mutex_t */
+#include <sched.h>    /* sched_yield */
+#include <fcntl.h>    /* open */
+#include <unistd.h>   /* close */
+#include <sys/mman.h> /* mmap, munmap */
+#include <sys/stat.h> /* fstat */
 #include "../include/avl.h"
 
+/* hint the cache to start loading addr, where the compiler supports it */
+#ifdef __GNUC__
+#define AVL_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define AVL_PREFETCH(addr) ((void) (addr))
+#endif
+
+/* lookups advanced in lockstep by AVLFindMany */
+#define AVL_FIND_GROUP (16)
+
+/* nodes per slab chunk when AVLCreateWithPool is given 0 */
+#define AVL_DEFAULT_CHUNK (1024)
+
+/* most nodes one copy-on-write update can copy or retire: the path down to
+ * the successor, two rotation copies per level, and the new leaf */
+#define AVL_WRITE_NODES (3 * AVL_MAX_HEIGHT + 1)
+
+/* initial room for retired nodes; reclaiming runs each time it fills up */
+#define AVL_RETIRE_BATCH (4096)
+
+/* AVLParallelForEach cuts the tree into about this many tasks per thread,
+ * but never into subtrees smaller than AVL_TASK_MIN members */
+#define AVL_TASKS_PER_THREAD (8)
+#define AVL_TASK_MIN (256)
+
+/* reader counters, each on its own cache line */
+#define AVL_READER_STRIPES (32)
+#define AVL_CACHE_LINE (64)
+
+/* counters for AVLGetStats, compiled in only with -DAVL_STATS. they are
+ * bumped from const read paths too, so they go through a cast and relaxed
+ * atomics */
+#ifdef AVL_STATS
+#define AVL_STAT_ADD(tree, field, n)                                           \
+	__atomic_fetch_add(&((avl_t*) (tree))->stats.field, (n), __ATOMIC_RELAXED)
+#else
+#define AVL_STAT_ADD(tree, field, n) ((void) 0)
+#endif
+
+/* first room a multiset key gets for its values */
+#define AVL_GROUP_MIN (4)
+
+/* all values of a multiset key, in insertion order */
+typedef struct group_s
+{
+	size_t count;
+	size_t cap;
+	void* values[];
+} group_t;
+
 /* node definition */
 struct node_s
 {
 	node_t* side[2];
-	void* data;
-	size_t height;
+	void* data; /* for a multiset key, its first value */
+	size_t size; /* members in this subtree, for order statistics */
+	union
+	{
+		size_t birth;   /* tree version that created it, for copy-on-write */
+		group_t* group; /* values of a multiset key, when grouped is set */
+	} extra;
+	uint32_t key;          /* prefix of data, 0 for trees without a prefix */
+	unsigned char height;  /* at most AVL_MAX_HEIGHT */
+	unsigned char grouped; /* only ever set in multisets, never copy-on-write */
 };
 
+/* slab chunk: a header followed by chunk_nodes contiguous nodes */
+typedef struct chunk_s chunk_t;
+struct chunk_s
+{
+	chunk_t* next;
+	node_t nodes[];
+};
+
+/* node pool definition. chunk_nodes == 0 means nodes come from malloc */
+typedef struct pool_s
+{
+	chunk_t* chunks;    /* all chunks, newest first */
+	node_t* free_list;  /* recycled nodes, linked through side[0] */
+	size_t chunk_nodes; /* nodes per chunk */
+	size_t used;        /* nodes handed out from the newest chunk */
+} pool_t;
+
+/* reader counter padded to a cache line of its own */
+typedef struct reader_slot_s
+{
+	size_t count;
+	char pad[AVL_CACHE_LINE - sizeof(size_t)];
+} reader_slot_t;
+
+/* a node unlinked by a copy-on-write update */
+typedef struct retired_s
+{
+	node_t* node;
+	size_t version; /* version of the update that unlinked it */
+} retired_t;
+
+/* copy-on-write state, for persistent and concurrent trees. retired nodes
+ * are recycled once no snapshot and no reader can reach them. in concurrent
+ * mode readers announce themselves in the counters of the current epoch
+ * parity; the writer flips the epoch and waits for the old parity to drain */
+typedef struct cow_s
+{
+	reader_slot_t readers[2][AVL_READER_STRIPES];
+	unsigned epoch;
+	int concurrent;
+	pthread_mutex_t write_lock;
+	avl_t* snapshots; /* live snapshots, linked through next */
+	retired_t* retired;
+	size_t retired_count;
+	size_t retired_cap;
+	size_t retired_mark; /* retired_count when the current update began */
+} cow_t;
+
 /* tree definition */
 struct avl_s
 {
 	node_t* root;
 	avl_cmp_t cmp_func;
+	avl_prefix_t prefix_func; /* NULL: every node's key is 0 */
+	int multi;                /* equal keys share a node, see AVLSetMultiset */
+	size_t count;
+	size_t version; /* bumped by every copy-on-write update */
+	cow_t* cow;     /* NULL unless persistent or concurrent */
+	avl_t* origin;  /* for a snapshot: the tree it was taken from */
+	avl_t* next;    /* for a snapshot: next live snapshot of origin */
+	pool_t pool;
+#ifdef AVL_STATS
+	avl_stats_t stats;
+#endif
+};
+
+/* frozen snapshot definition: members in Eytzinger (BFS) order, so the
+ * children of item k are items 2k and 2k + 1, counting from 1. item k is
+ * stored at base + (k - 1) * stride: a data pointer for AVLFreeze, the data
+ * itself for a file mapped by AVLLoad */
+struct avl_frozen_s
+{
+	const char* base;
+	size_t stride;
+	int indirect; /* items are pointers to the data */
+	size_t count;
+	avl_cmp_t cmp_func;
+	void* storage;   /* pointer array or file mapping, released on destroy */
+	size_t map_size; /* 0 unless storage is a mapping */
 };
 
+/* a piece of a parallel traversal: a whole subtree, or a single node whose
+ * subtrees are tasks of their own */
+typedef struct task_s
+{
+	node_t* node;
+	int whole;
+	int status; /* op's result, 0 if it never failed */
+	void* part; /* private accumulator when reducing */
+} task_t;
+
+/* a worker's share of the tasks. the owner takes from the head, thieves
+ * from the tail */
+typedef struct deque_s
+{
+	pthread_mutex_t lock;
+	size_t head;
+	size_t tail;
+} deque_t;
+
+/* one parallel traversal */
+typedef struct job_s
+{
+	task_t* tasks;
+	deque_t* deques;
+	size_t workers;
+	avl_op_t op;
+	void* arg;
+	size_t part_size; /* 0: op gets arg instead of a part */
+	int stop;         /* set once an op fails */
+} job_t;
+
+typedef struct worker_s
+{
+	job_t* job;
+	size_t id;
+	pthread_t thread;
+} worker_t;
+
+/* file layout: the header, padding up to offset, then count records of
+ * record_size bytes in Eytzinger order. host byte order */
+#define AVL_FILE_MAGIC "AVLTREE1"
+#define AVL_FILE_ALIGN (64)
+
+typedef struct file_header_s
+{
+	char magic[8];
+	uint64_t count;
+	uint64_t record_size;
+	uint64_t offset; /* of the first record, from the start of the file */
+} file_header_t;
+
 /* ======================== HELPER FUNCS SIGNATURES ======================== */
 
 static size_t Height(node_t* node);
+static size_t Size(const node_t* node);
 static void UpdateHeight(node_t* node);
 static int BalanceFactor(node_t* node);
-static node_t* Rotate(node_t* root, int dir);
-static node_t* Rebalance(node_t* node);
-static node_t* NewNode(void* data);
-static node_t* InsertRec(node_t* root, void* data, avl_cmp_t cmp, int* status);
-static node_t* MinNode(node_t* node);
-static node_t* RemoveRec(node_t* root, const void* data, avl_cmp_t cmnodep);
-static size_t CountRec(const node_t* node);
+static node_t* Rotate(avl_t* tree, node_t* root, int dir);
+static node_t* Rebalance(avl_t* tree, node_t* node);
+static node_t* NewNode(avl_t* tree, void* data);
+static void FreeNode(avl_t* tree, node_t* node);
+static chunk_t* NewChunk(pool_t* pool, size_t nodes);
+static int Reserve(pool_t* pool, size_t nodes);
+static void DestroyPool(pool_t* pool);
+static node_t* BuildRec(node_t* nodes, void** items, size_t lo, size_t hi);
+static void Retrace(avl_t* tree, node_t** path[], size_t depth);
+static int BeginWrite(avl_t* tree);
+static void AbortWrite(avl_t* tree, node_t** path[], size_t depth);
+static void EndWrite(avl_t* tree, node_t* root, size_t count);
+static node_t* Own(avl_t* tree, node_t* node);
+static void Discard(avl_t* tree, node_t* node);
+static void Retire(avl_t* tree, node_t* node);
+static int IsPinned(const cow_t* cow, const retired_t* retired);
+static void Reclaim(avl_t* tree);
+static avl_t* CreateCow(avl_cmp_t sorting_method, int concurrent);
+static void LockWrites(const avl_t* tree);
+static void UnlockWrites(const avl_t* tree);
+static void ReleaseSnapshot(avl_t* snapshot);
+static size_t* EnterRead(const avl_t* tree);
+static void ExitRead(size_t* counter);
+static node_t* Root(const avl_t* tree);
+static int InsertIter(avl_t* tree, void* data);
+static void RemoveIter(avl_t* tree, const void* data);
 static int ForEachRec(node_t* node, avl_op_t op, void* arg);
-static void* FindRec(const node_t* node, const void* data, avl_cmp_t cmp);
+static int Visit(node_t* node, avl_op_t op, void* arg);
+static int RunParallel(avl_t* tree, avl_op_t op, void* arg, size_t part_size,
+                       avl_reduce_t reduce, size_t threads);
+static size_t CollectTasks(node_t* node, size_t grain, task_t* tasks,
+                           size_t n);
+static void* Worker(void* arg);
+static int TakeTask(job_t* job, size_t id, size_t* task);
+static int AppendValue(node_t* node, void* data);
+static int DropValue(node_t* node, const void* data);
+static int ForEachRangeRec(const avl_t* tree, node_t* node, const void* lo,
+                           uint32_t lo_key, const void* hi, uint32_t hi_key,
+                           avl_op_t op, void* arg);
+static void* Bound(const avl_t* tree, const void* data, int strict);
+static void IterDescend(avl_iter_t* iter, node_t* node, int dir);
+static void IterStep(avl_iter_t* iter, int dir);
+static void FreezeRec(avl_frozen_t* frozen, avl_iter_t* iter, size_t k);
+static size_t FrozenSearch(const avl_frozen_t* frozen, const void* data);
+static void* FrozenItem(const avl_frozen_t* frozen, size_t k);
+static node_t* FindNode(const avl_t* tree, node_t* node, const void* data,
+                        uint32_t key);
+static uint32_t KeyOf(const avl_t* tree, const void* data);
+static int Compare(const avl_t* tree, const void* data, uint32_t key,
+                   const node_t* node);
 static void DestroyRec(node_t* node);
+static void FreeRec(avl_t* tree, node_t* node);
+static node_t* Join(avl_t* tree, node_t* left, node_t* mid, node_t* right);
+static node_t* Join2(avl_t* tree, node_t* left, node_t* right);
+static node_t* SplitLast(avl_t* tree, node_t* node, node_t** last);
+static void Split(avl_t* tree, node_t* node, const void* data, uint32_t key,
+                  node_t** left, node_t** found, node_t** right);
+static node_t* CopyRec(avl_t* tree, const node_t* node, int* status);
+static node_t* UnionRec(avl_t* tree, node_t* t1, const node_t* t2, int* status);
+static node_t* IntersectRec(avl_t* tree, node_t* t1, const node_t* t2);
+static node_t* DifferenceRec(avl_t* tree, node_t* t1, const node_t* t2);
+static int CanRebuild(const avl_t* tree);
+static void MergePool(pool_t* dest, pool_t* src);
 
 /* ========================================================================= */
 
@@ -51,25 +296,212 @@ static void DestroyRec(node_t* node);
 
 avl_t* AVLCreate(avl_cmp_t sorting_method)
 {
-	avl_t* tree = malloc(sizeof(avl_t));
-	if (!tree)
-		return NULL;
+	avl_t* tree = NULL;
 
 	if (!sorting_method)
 		return NULL;
 
+	tree = malloc(sizeof(avl_t));
+	if (!tree)
+		return NULL;
+
 	tree->root = NULL;
 	tree->cmp_func = sorting_method;
+	tree->prefix_func = NULL;
+	tree->multi = 0;
+	tree->count = 0;
+	tree->version = 0;
+	tree->cow = NULL;
+	tree->origin = NULL;
+	tree->next = NULL;
+	tree->pool.chunks = NULL;
+	tree->pool.free_list = NULL;
+	tree->pool.chunk_nodes = 0;
+	tree->pool.used = 0;
+#ifdef AVL_STATS
+	memset(&tree->stats, 0, sizeof(tree->stats));
+#endif
+	return tree;
+}
+
+avl_t* AVLCreateWithPool(avl_cmp_t sorting_method, size_t chunk_size)
+{
+	avl_t* tree = AVLCreate(sorting_method);
+	if (!tree)
+		return NULL;
+
+	tree->pool.chunk_nodes = chunk_size ? chunk_size : AVL_DEFAULT_CHUNK;
+	/* no chunk yet: force the first NewNode to allocate one */
+	tree->pool.used = tree->pool.chunk_nodes;
+	return tree;
+}
+
+avl_t* AVLCreatePersistent(avl_cmp_t sorting_method)
+{
+	return CreateCow(sorting_method, 0);
+}
+
+avl_t* AVLCreateConcurrent(avl_cmp_t sorting_method)
+{
+	return CreateCow(sorting_method, 1);
+}
+
+/* ================================ SNAPSHOT ================================ */
+
+avl_t* AVLSnapshot(avl_t* tree)
+{
+	avl_t* snapshot = NULL;
+
+	if (!tree || !tree->cow)
+		return NULL;
+	snapshot = AVLCreate(tree->cmp_func);
+	if (!snapshot)
+		return NULL;
+
+	/* the next update bumps the version, so it copies every node seen here */
+	LockWrites(tree);
+	snapshot->prefix_func = tree->prefix_func;
+	snapshot->root = tree->root;
+	snapshot->count = tree->count;
+	snapshot->version = tree->version;
+	snapshot->origin = tree;
+	snapshot->next = tree->cow->snapshots;
+	tree->cow->snapshots = snapshot;
+	UnlockWrites(tree);
+	return snapshot;
+}
+
+/* ============================ BUILD FROM SORTED ============================ */
+
+avl_t* AVLBuildFromSorted(avl_cmp_t sorting_method, void** items, size_t n)
+{
+	avl_t* tree = NULL;
+	chunk_t* chunk = NULL;
+	size_t i = 0;
+
+	if (!sorting_method || (!items && n))
+		return NULL;
+	for (i = 1; i < n; ++i)
+	{
+		/* strictly ascending, as the tree doesn't support duplicates */
+		if (sorting_method(items[i], items[i - 1]) <= 0)
+			return NULL;
+	}
+
+	tree = AVLCreateWithPool(sorting_method, 0);
+	if (!tree || !n)
+		return tree;
+
+	/* one chunk holding exactly n nodes, later inserts get their own */
+	chunk = NewChunk(&tree->pool, n);
+	if (!chunk)
+	{
+		AVLDestroy(tree);
+		return NULL;
+	}
+	tree->root = BuildRec(chunk->nodes, items, 0, n);
+	tree->count = n;
+	/* the ascending check and the nodes carved from the chunk */
+	AVL_STAT_ADD(tree, comparisons, n - 1);
+	AVL_STAT_ADD(tree, allocations, n);
 	return tree;
 }
 
+/* ================================= PREFIX ================================= */
+
+int AVLSetPrefix(avl_t* tree, avl_prefix_t prefix)
+{
+	if (!tree || tree->origin || tree->root)
+		return -1;
+	tree->prefix_func = prefix;
+	return 0;
+}
+
+uint32_t AVLStringPrefix(const void* data)
+{
+	const unsigned char* str = data;
+	uint32_t key = 0;
+	int i = 0;
+
+	/* bytes past the terminator stay 0, which sorts first like strcmp */
+	for (i = 0; i < 4; ++i)
+	{
+		key <<= 8;
+		if (*str)
+			key |= *str++;
+	}
+	return key;
+}
+
+/* ================================ MULTISET ================================ */
+
+int AVLSetMultiset(avl_t* tree)
+{
+	/* groups change in place, which copy-on-write readers must not see */
+	if (!tree || tree->cow || tree->origin || tree->root)
+		return -1;
+	tree->multi = 1;
+	return 0;
+}
+
+/* ================================= STATS ================================= */
+
+int AVLGetStats(const avl_t* tree, avl_stats_t* stats)
+{
+	assert(stats);
+	memset(stats, 0, sizeof(*stats));
+#ifdef AVL_STATS
+	if (!tree)
+		return -1;
+	*stats = tree->stats;
+	return 0;
+#else
+	(void) tree;
+	return -1;
+#endif
+}
+
+void AVLResetStats(avl_t* tree)
+{
+#ifdef AVL_STATS
+	if (tree)
+		memset(&tree->stats, 0, sizeof(tree->stats));
+#else
+	(void) tree;
+#endif
+}
+
 /* ================================ DESTROY ================================ */
 
 void AVLDestroy(avl_t* tree)
 {
 	if (!tree)
 		return;
-	DestroyRec(tree->root);
+	if (tree->origin)
+	{
+		ReleaseSnapshot(tree);
+		return;
+	}
+	if (tree->cow)
+	{
+		/* snapshots share its nodes, so they must go first */
+		assert(!tree->cow->snapshots);
+		/* retired nodes live in the pool and go with it */
+		pthread_mutex_destroy(&tree->cow->write_lock);
+		free(tree->cow->retired);
+		free(tree->cow);
+	}
+	if (tree->pool.chunk_nodes)
+	{
+		/* the chunks go at once, but groups are allocated one by one */
+		if (tree->multi)
+			FreeRec(tree, tree->root);
+		DestroyPool(&tree->pool);
+	}
+	else
+	{
+		DestroyRec(tree->root);
+	}
 	free(tree);
 }
 
@@ -79,7 +511,7 @@ size_t AVLCount(const avl_t* tree)
 {
 	if (!tree)
 		return 0;
-	return CountRec(tree->root);
+	return __atomic_load_n(&tree->count, __ATOMIC_RELAXED);
 }
 
 /* ================================ ISEMPTY ================================ */
@@ -87,7 +519,7 @@ size_t AVLCount(const avl_t* tree)
 int AVLIsEmpty(const avl_t* tree)
 {
 	assert(tree);
-	return tree->root == NULL;
+	return Root(tree) == NULL;
 }
 
 /* ================================= INSERT ================================= */
@@ -95,9 +527,14 @@ int AVLIsEmpty(const avl_t* tree)
 int AVLInsert(avl_t* tree, void* data)
 {
 	int status = 0;
+
 	if (!tree || !tree->cmp_func)
 		return 0;
-	tree->root = InsertRec(tree->root, data, tree->cmp_func, &status);
+	if (tree->origin)
+		return -1; /* snapshots are read only */
+	LockWrites(tree);
+	status = InsertIter(tree, data);
+	UnlockWrites(tree);
 	return status;
 }
 
@@ -105,8 +542,46 @@ int AVLInsert(avl_t* tree, void* data)
 
 void AVLRemove(avl_t* tree, const void* data)
 {
-	if (tree && tree->cmp_func)
-		tree->root = RemoveRec(tree->root, data, tree->cmp_func);
+	if (!tree || !tree->cmp_func || tree->origin)
+		return;
+	LockWrites(tree);
+	RemoveIter(tree, data);
+	UnlockWrites(tree);
+}
+
+/* ============================== REMOVE VALUE ============================== */
+
+int AVLRemoveValue(avl_t* tree, const void* data)
+{
+	node_t* node = NULL;
+	int status = -1;
+
+	if (!tree || !tree->cmp_func || tree->origin)
+		return -1;
+	LockWrites(tree);
+	node = FindNode(tree, tree->root, data, KeyOf(tree, data));
+	if (node && node->grouped)
+	{
+		status = DropValue(node, data);
+	}
+	else if (node && node->data == data)
+	{
+		RemoveIter(tree, data);
+		status = 0;
+	}
+	UnlockWrites(tree);
+	return status;
+}
+
+/* ============================== SYNCHRONIZE ============================== */
+
+void AVLSynchronize(avl_t* tree)
+{
+	if (!tree || !tree->cow)
+		return;
+	LockWrites(tree);
+	Reclaim(tree);
+	UnlockWrites(tree);
 }
 
 /* ================================ FOREACH ================================ */
@@ -118,228 +593,1762 @@ int AVLForEach(avl_t* tree, avl_op_t operation, void* arg)
 	return ForEachRec(tree->root, operation, arg);
 }
 
-/* ================================== FIND ================================== */
+/* ============================ PARALLEL FOREACH ============================ */
 
-void* AVLFind(const avl_t* tree, const void* data)
+int AVLParallelForEach(avl_t* tree, avl_op_t operation, void* arg,
+                       size_t threads)
 {
-	if (!tree || !tree->cmp_func)
-		return NULL;
-	return FindRec(tree->root, data, tree->cmp_func);
+	if (!tree || !operation)
+		return 0;
+	return RunParallel(tree, operation, arg, 0, NULL, threads);
 }
 
-/* ================================= HEIGHT ================================= */
+/* ============================ PARALLEL REDUCE ============================ */
 
-size_t AVLHeight(const avl_t* tree)
+int AVLParallelReduce(avl_t* tree, avl_op_t operation, size_t part_size,
+                      avl_reduce_t reduce, void* arg, size_t threads)
 {
-	if (!tree)
+	if (!tree || !operation || !part_size || !reduce)
+		return -1;
+	return RunParallel(tree, operation, arg, part_size, reduce, threads);
+}
+
+/* ============================= FOREACH RANGE ============================= */
+
+int AVLForEachRange(avl_t* tree, const void* lo, const void* hi,
+                    avl_op_t operation, void* arg)
+{
+	if (!tree || !tree->cmp_func || !operation)
 		return 0;
-	return Height(tree->root);
+	return ForEachRangeRec(tree, tree->root, lo, KeyOf(tree, lo), hi,
+	                       KeyOf(tree, hi), operation, arg);
 }
 
-/* ========================================================================= */
+/* ============================== LOWER BOUND ============================== */
 
-/* ========================================================================
- *                                                                        *
- *                              HELPER FUNCS                              *
- *                                                                        *
- ======================================================================== */
+void* AVLLowerBound(const avl_t* tree, const void* data)
+{
+	return Bound(tree, data, 0);
+}
 
-/* ============================= DESTROY HELPER ============================= */
+/* ============================== UPPER BOUND ============================== */
 
-/* recursive destroy */
-static void DestroyRec(node_t* node)
+void* AVLUpperBound(const avl_t* tree, const void* data)
 {
-	if (!node)
-		return;
-	DestroyRec(node->side[0]);
-	DestroyRec(node->side[1]);
-	free(node);
+	return Bound(tree, data, 1);
 }
 
-/* ============================== COUNT HELPER ============================== */
+/* ================================== FIND ================================== */
 
-/* recursive count */
-static size_t CountRec(const node_t* node)
+void* AVLFind(const avl_t* tree, const void* data)
 {
-	if (!node)
-		return 0;
-	return 1 + CountRec(node->side[0]) + CountRec(node->side[1]);
+	size_t* reader = NULL;
+	node_t* node = NULL;
+	void* found = NULL;
+
+	if (!tree || !tree->cmp_func)
+		return NULL;
+	reader = EnterRead(tree);
+	node = FindNode(tree, Root(tree), data, KeyOf(tree, data));
+	if (node)
+		found = node->data;
+	ExitRead(reader);
+	return found;
 }
 
-/* ============================= INSERT HELPER ============================= */
+/* ================================ FIND ALL ================================ */
 
-/* recursive insert */
-static node_t* InsertRec(node_t* root, void* data, avl_cmp_t cmp, int* status)
+size_t AVLFindAll(const avl_t* tree, const void* data, void* const** values)
 {
-	int dir = 0;
-	int cmp_res = 0;
+	size_t* reader = NULL;
 	node_t* node = NULL;
+	size_t count = 0;
 
-	if (!root)
+	assert(values);
+	*values = NULL;
+	if (!tree || !tree->cmp_func)
+		return 0;
+	reader = EnterRead(tree);
+	node = FindNode(tree, Root(tree), data, KeyOf(tree, data));
+	if (node && node->grouped)
 	{
-		node = NewNode(data);
-		if (!node)
-			*status = -1;
-		return node;
+		*values = node->extra.group->values;
+		count = node->extra.group->count;
 	}
-	cmp_res = cmp(data, root->data);
-	if (cmp_res == 0)
+	else if (node)
 	{
-		/* duplicates not supported */
-		*status = -1;
-		return root;
+		*values = &node->data;
+		count = 1;
 	}
-	dir = cmp_res > 0;
-	root->side[dir] = InsertRec(root->side[dir], data, cmp, status);
-	if (*status)
-		return root;
-	return Rebalance(root);
+	ExitRead(reader);
+	return count;
 }
 
-/* ============================ GENERAL HELPERS ============================ */
+/* =============================== FIND MANY =============================== */
 
-/* create new node */
-static node_t* NewNode(void* data)
+size_t AVLFindMany(const avl_t* tree, const void** keys, size_t n, void** out)
 {
-	node_t* node = malloc(sizeof(node_t));
-	if (!node)
-		return NULL;
-	node->side[0] = node->side[1] = NULL;
-	node->data = data;
-	node->height = 1;
-	return node;
-}
+	const node_t* cursor[AVL_FIND_GROUP];
+	uint32_t key[AVL_FIND_GROUP];
+	const node_t* root = NULL;
+	size_t* reader = NULL;
+	size_t found = 0;
+	size_t base = 0;
+	size_t group = 0;
+	size_t active = 0;
+	size_t i = 0;
+	int cmp_res = 0;
 
-/* rebalance subtree */
-static node_t* Rebalance(node_t* node)
-{
-	int bf = 0;
-	UpdateHeight(node);
-	bf = BalanceFactor(node);
-	if (bf > 1)
+	if (!tree || !tree->cmp_func)
+		return 0;
+
+	reader = EnterRead(tree);
+	root = Root(tree);
+	for (base = 0; base < n; base += group)
 	{
-		/* right-heavy */
-		if (BalanceFactor(node->side[1]) < 0)
+		group = n - base < AVL_FIND_GROUP ? n - base : AVL_FIND_GROUP;
+		for (i = 0; i < group; ++i)
 		{
-			/* RL case */
-			node->side[1] = Rotate(node->side[1], 1);
+			cursor[i] = root;
+			key[i] = KeyOf(tree, keys[base + i]);
+			out[base + i] = NULL;
 		}
-		/* RR case */
-		return Rotate(node, 0);
-	}
-	if (bf < -1)
-	{
-		/* left-heavy */
-		if (BalanceFactor(node->side[0]) > 0)
+
+		/* one level per round for every lookup still descending, so the
+		 * node loads of independent lookups overlap */
+		active = root ? group : 0;
+		while (active)
 		{
-			/* LR case */
-			node->side[0] = Rotate(node->side[0], 0);
+			active = 0;
+			for (i = 0; i < group; ++i)
+			{
+				if (!cursor[i])
+					continue;
+				cmp_res = Compare(tree, keys[base + i], key[i], cursor[i]);
+				if (cmp_res == 0)
+				{
+					out[base + i] = cursor[i]->data;
+					++found;
+					cursor[i] = NULL;
+					continue;
+				}
+				cursor[i] = cursor[i]->side[cmp_res > 0];
+				if (cursor[i])
+				{
+					AVL_PREFETCH(cursor[i]);
+					++active;
+				}
+			}
 		}
-		/* LL case */
-		return Rotate(node, 1);
 	}
-	return node;
+	ExitRead(reader);
+	return found;
 }
 
-/* helper: update height of node from children */
-static void UpdateHeight(node_t* node)
-{
-	size_t lh = Height(node->side[0]);
-	size_t rh = Height(node->side[1]);
-	node->height = (lh > rh ? lh : rh) + 1;
-}
+/* ================================= HEIGHT ================================= */
 
-/* helper: get height of node (0 if null) */
-static size_t Height(node_t* node)
+size_t AVLHeight(const avl_t* tree)
 {
-	return node ? node->height : 0;
-}
+	size_t* reader = NULL;
+	size_t height = 0;
 
-/* helper: get balance factor = right height - left height */
-static int BalanceFactor(node_t* n)
-{
-	return (int) Height(n->side[1]) - (int) Height(n->side[0]);
+	if (!tree)
+		return 0;
+	reader = EnterRead(tree);
+	height = Height(Root(tree));
+	ExitRead(reader);
+	return height;
 }
 
-/* single rotation: dir = 0 => right rotation; dir = 1 => left rotation */
-static node_t* Rotate(node_t* root, int dir)
+/* ================================ ITERATOR ================================ */
+
+void AVLIterBegin(const avl_t* tree, avl_iter_t* iter)
 {
-	int opp = dir ^ 1;
-	node_t* pivot = root->side[opp];
-	root->side[opp] = pivot->side[dir];
-	pivot->side[dir] = root;
-	UpdateHeight(root);
-	UpdateHeight(pivot);
-	return pivot;
+	assert(iter);
+	iter->tree = tree;
+	iter->depth = 0;
+	if (tree)
+		IterDescend(iter, tree->root, 0);
 }
 
-/* recursive find minimum node in subtree */
-static node_t* MinNode(node_t* node)
+void AVLIterEnd(const avl_t* tree, avl_iter_t* iter)
 {
-	while (node->side[0])
-		node = node->side[0];
-	return node;
+	assert(iter);
+	iter->tree = tree;
+	iter->depth = 0;
 }
 
-/* recursive removal */
-static node_t* RemoveRec(node_t* root, const void* data, avl_cmp_t cmp)
+void AVLIterSeek(const avl_t* tree, const void* data, avl_iter_t* iter)
 {
+	node_t* node = NULL;
+	size_t best = 0;
+	uint32_t key = 0;
 	int cmp_res = 0;
-	node_t* child = NULL;
-	node_t* succ = NULL;
-	int dir = 0;
 
-	if (!root)
-		return NULL;
-	cmp_res = cmp(data, root->data);
-	if (cmp_res == 0)
+	assert(iter);
+	iter->tree = tree;
+	iter->depth = 0;
+	if (!tree || !tree->cmp_func)
+		return;
+	key = KeyOf(tree, data);
+	node = tree->root;
+	while (node)
 	{
-		/* remove this node */
-		if (!root->side[0] || !root->side[1])
+		iter->path[iter->depth++] = node;
+		cmp_res = Compare(tree, data, key, node);
+		if (cmp_res <= 0)
 		{
-			child = root->side[0] ? root->side[0] : root->side[1];
-			free(root);
-			return child;
+			/* candidate - its path is the current prefix */
+			best = iter->depth;
+			if (cmp_res == 0)
+				break;
 		}
-		/* two children: replace with successor */
-		succ = MinNode(root->side[1]);
-		root->data = succ->data;
-		root->side[1] = RemoveRec(root->side[1], succ->data, cmp);
-	}
-	else
-	{
-		dir = cmp_res > 0;
-		root->side[dir] = RemoveRec(root->side[dir], data, cmp);
+		node = node->side[cmp_res > 0];
 	}
-	return Rebalance(root);
+	iter->depth = best;
 }
 
-/* recursive for-each (in-order) */
-static int ForEachRec(node_t* node, avl_op_t op, void* arg)
+void AVLIterNext(avl_iter_t* iter)
 {
-	int res = 0;
-	if (!node)
-		return 0;
-	res = ForEachRec(node->side[0], op, arg);
-	if (res)
-		return res;
-	res = op(node->data, arg);
-	if (res)
-		return res;
-	return ForEachRec(node->side[1], op, arg);
+	assert(iter);
+	IterStep(iter, 1);
 }
 
-/* recursive find */
-static void* FindRec(const node_t* node, const void* data, avl_cmp_t cmp)
+void AVLIterPrev(avl_iter_t* iter)
 {
-	int cmp_res = 0;
-	int dir = 0;
+	assert(iter);
+	IterStep(iter, 0);
+}
 
-	if (!node)
-		return NULL;
-	cmp_res = cmp(data, node->data);
-	if (cmp_res == 0)
-		return node->data;
-	dir = cmp_res > 0;
-	return FindRec(node->side[dir], data, cmp);
+int AVLIterIsEnd(const avl_iter_t* iter)
+{
+	assert(iter);
+	return iter->depth == 0;
+}
+
+void* AVLIterGetData(const avl_iter_t* iter)
+{
+	assert(iter);
+	return iter->depth ? iter->path[iter->depth - 1]->data : NULL;
+}
+
+/* ================================= SELECT ================================= */
+
+void* AVLSelect(const avl_t* tree, size_t k)
+{
+	const node_t* node = NULL;
+	size_t* reader = NULL;
+	void* found = NULL;
+	size_t left = 0;
+
+	if (!tree)
+		return NULL;
+	reader = EnterRead(tree);
+	node = Root(tree);
+	while (node)
+	{
+		left = Size(node->side[0]);
+		if (k == left)
+		{
+			found = node->data;
+			break;
+		}
+		if (k < left)
+		{
+			node = node->side[0];
+		}
+		else
+		{
+			k -= left + 1;
+			node = node->side[1];
+		}
+	}
+	ExitRead(reader);
+	return found;
+}
+
+/* ================================== RANK ================================== */
+
+size_t AVLRank(const avl_t* tree, const void* data)
+{
+	const node_t* node = NULL;
+	size_t* reader = NULL;
+	size_t rank = 0;
+	uint32_t key = 0;
+	int cmp_res = 0;
+
+	if (!tree || !tree->cmp_func)
+		return 0;
+	key = KeyOf(tree, data);
+	reader = EnterRead(tree);
+	node = Root(tree);
+	while (node)
+	{
+		cmp_res = Compare(tree, data, key, node);
+		if (cmp_res == 0)
+		{
+			rank += Size(node->side[0]);
+			break;
+		}
+		if (cmp_res > 0)
+			rank += Size(node->side[0]) + 1;
+		node = node->side[cmp_res > 0];
+	}
+	ExitRead(reader);
+	return rank;
+}
+
+/* ================================= UNION ================================= */
+
+int AVLUnion(avl_t* dest, const avl_t* src)
+{
+	size_t* reader = NULL;
+	int status = 0;
+
+	if (!CanRebuild(dest) || !src || dest == src || dest->multi || src->multi)
+		return -1;
+	reader = EnterRead(src);
+	dest->root = UnionRec(dest, dest->root, Root(src), &status);
+	ExitRead(reader);
+	dest->count = Size(dest->root);
+	return status;
+}
+
+/* =============================== INTERSECT =============================== */
+
+int AVLIntersect(avl_t* dest, const avl_t* src)
+{
+	size_t* reader = NULL;
+
+	if (!CanRebuild(dest) || !src || dest->multi || src->multi)
+		return -1;
+	if (dest == src)
+		return 0;
+	reader = EnterRead(src);
+	dest->root = IntersectRec(dest, dest->root, Root(src));
+	ExitRead(reader);
+	dest->count = Size(dest->root);
+	return 0;
+}
+
+/* =============================== DIFFERENCE =============================== */
+
+int AVLDifference(avl_t* dest, const avl_t* src)
+{
+	size_t* reader = NULL;
+
+	if (!CanRebuild(dest) || !src || dest->multi || src->multi)
+		return -1;
+	if (dest == src)
+	{
+		FreeRec(dest, dest->root);
+		dest->root = NULL;
+		dest->count = 0;
+		return 0;
+	}
+	reader = EnterRead(src);
+	dest->root = DifferenceRec(dest, dest->root, Root(src));
+	ExitRead(reader);
+	dest->count = Size(dest->root);
+	return 0;
+}
+
+/* ================================= SPLIT ================================= */
+
+avl_t* AVLSplit(avl_t* tree, const void* data)
+{
+	avl_t* right = NULL;
+	node_t* found = NULL;
+
+	/* the split off nodes must be freeable on their own */
+	if (!CanRebuild(tree) || tree->pool.chunk_nodes)
+		return NULL;
+	right = AVLCreate(tree->cmp_func);
+	if (!right)
+		return NULL;
+	right->prefix_func = tree->prefix_func;
+	right->multi = tree->multi;
+
+	Split(tree, tree->root, data, KeyOf(tree, data), &tree->root, &found,
+	      &right->root);
+	if (found)
+		tree->root = Join(tree, tree->root, found, NULL);
+	tree->count = Size(tree->root);
+	right->count = Size(right->root);
+	return right;
+}
+
+/* ================================== JOIN ================================== */
+
+int AVLJoin(avl_t* left, avl_t* right)
+{
+	const node_t* max = NULL;
+	const node_t* min = NULL;
+
+	if (!CanRebuild(left) || !CanRebuild(right) || left == right)
+		return -1;
+	/* nodes can only move between trees that free them the same way */
+	if (!left->pool.chunk_nodes != !right->pool.chunk_nodes)
+		return -1;
+	/* and whose inline keys mean the same */
+	if (left->prefix_func != right->prefix_func || left->multi != right->multi)
+		return -1;
+	if (left->root && right->root)
+	{
+		for (max = left->root; max->side[1]; max = max->side[1])
+			;
+		for (min = right->root; min->side[0]; min = min->side[0])
+			;
+		if (Compare(left, max->data, max->key, min) >= 0)
+			return -1;
+	}
+
+	left->root = Join2(left, left->root, right->root);
+	left->count += right->count;
+	right->root = NULL;
+	right->count = 0;
+	if (left->pool.chunk_nodes)
+		MergePool(&left->pool, &right->pool);
+	return 0;
+}
+
+/* ================================= FREEZE ================================= */
+
+avl_frozen_t* AVLFreeze(const avl_t* tree)
+{
+	avl_frozen_t* frozen = NULL;
+	avl_iter_t iter;
+
+	if (!tree)
+		return NULL;
+	frozen = malloc(sizeof(avl_frozen_t));
+	if (!frozen)
+		return NULL;
+	/* one extra slot keeps malloc(0) out of the way */
+	frozen->storage = malloc((tree->count + 1) * sizeof(void*));
+	if (!frozen->storage)
+	{
+		free(frozen);
+		return NULL;
+	}
+	frozen->base = frozen->storage;
+	frozen->stride = sizeof(void*);
+	frozen->indirect = 1;
+	frozen->count = tree->count;
+	frozen->cmp_func = tree->cmp_func;
+	frozen->map_size = 0;
+
+	AVLIterBegin(tree, &iter);
+	FreezeRec(frozen, &iter, 1);
+	return frozen;
+}
+
+void AVLFrozenDestroy(avl_frozen_t* frozen)
+{
+	if (!frozen)
+		return;
+	if (frozen->map_size)
+		munmap(frozen->storage, frozen->map_size);
+	else
+		free(frozen->storage);
+	free(frozen);
+}
+
+size_t AVLFrozenCount(const avl_frozen_t* frozen)
+{
+	return frozen ? frozen->count : 0;
+}
+
+void* AVLFrozenFind(const avl_frozen_t* frozen, const void* data)
+{
+	size_t k = 0;
+
+	if (!frozen)
+		return NULL;
+	k = FrozenSearch(frozen, data);
+	if (!k || frozen->cmp_func(data, FrozenItem(frozen, k)) != 0)
+		return NULL;
+	return FrozenItem(frozen, k);
+}
+
+void* AVLFrozenLowerBound(const avl_frozen_t* frozen, const void* data)
+{
+	size_t k = 0;
+
+	if (!frozen)
+		return NULL;
+	k = FrozenSearch(frozen, data);
+	return k ? FrozenItem(frozen, k) : NULL;
+}
+
+/* ================================== SAVE ================================== */
+
+int AVLSave(const avl_t* tree, const char* path, size_t record_size)
+{
+	static const char pad[AVL_FILE_ALIGN];
+	avl_frozen_t* frozen = NULL;
+	file_header_t header;
+	FILE* file = NULL;
+	size_t k = 0;
+	int status = 0;
+
+	if (!tree || !path || !record_size)
+		return -1;
+	/* the frozen snapshot already has the on-disk order */
+	frozen = AVLFreeze(tree);
+	if (!frozen)
+		return -1;
+	file = fopen(path, "wb");
+	if (!file)
+	{
+		AVLFrozenDestroy(frozen);
+		return -1;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, AVL_FILE_MAGIC, sizeof(header.magic));
+	header.count = frozen->count;
+	header.record_size = record_size;
+	header.offset = AVL_FILE_ALIGN;
+	status |= fwrite(&header, sizeof(header), 1, file) != 1;
+	status |= fwrite(pad, AVL_FILE_ALIGN - sizeof(header), 1, file) != 1;
+	for (k = 1; k <= frozen->count && !status; ++k)
+		status |= fwrite(FrozenItem(frozen, k), record_size, 1, file) != 1;
+	status |= fclose(file) != 0;
+
+	AVLFrozenDestroy(frozen);
+	return status ? -1 : 0;
+}
+
+/* ================================== LOAD ================================== */
+
+avl_frozen_t* AVLLoad(const char* path, avl_cmp_t sorting_method)
+{
+	const file_header_t* header = NULL;
+	avl_frozen_t* frozen = NULL;
+	struct stat info;
+	void* map = NULL;
+	int fd = -1;
+
+	if (!path || !sorting_method)
+		return NULL;
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &info) || (size_t) info.st_size < sizeof(file_header_t))
+	{
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	/* the mapping stays valid after the descriptor is gone */
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	header = map;
+	if (memcmp(header->magic, AVL_FILE_MAGIC, sizeof(header->magic)) ||
+	    !header->record_size || header->offset < sizeof(file_header_t) ||
+	    header->offset > (uint64_t) info.st_size ||
+	    header->count > ((uint64_t) info.st_size - header->offset) /
+	                        header->record_size ||
+	    !(frozen = malloc(sizeof(avl_frozen_t))))
+	{
+		munmap(map, info.st_size);
+		return NULL;
+	}
+
+	/* nothing is read here: pages fault in as searches touch them */
+	frozen->base = (const char*) map + header->offset;
+	frozen->stride = header->record_size;
+	frozen->indirect = 0;
+	frozen->count = header->count;
+	frozen->cmp_func = sorting_method;
+	frozen->storage = map;
+	frozen->map_size = info.st_size;
+	return frozen;
+}
+
+/* ========================================================================= */
+
+/* ========================================================================
+ *                                                                        *
+ *                              HELPER FUNCS                              *
+ *                                                                        *
+ ======================================================================== */
+
+/* ============================= DESTROY HELPER ============================= */
+
+/* recursive destroy */
+static void DestroyRec(node_t* node)
+{
+	if (!node)
+		return;
+	DestroyRec(node->side[0]);
+	DestroyRec(node->side[1]);
+	if (node->grouped)
+		free(node->extra.group);
+	free(node);
+}
+
+/* ============================ SET OP HELPERS ============================ */
+
+/* set operations relink nodes in place, so no copy-on-write or snapshot */
+static int CanRebuild(const avl_t* tree)
+{
+	return tree && tree->cmp_func && !tree->cow && !tree->origin;
+}
+
+/* recursive destroy through the tree's allocator */
+static void FreeRec(avl_t* tree, node_t* node)
+{
+	if (!node)
+		return;
+	FreeRec(tree, node->side[0]);
+	FreeRec(tree, node->side[1]);
+	FreeNode(tree, node);
+}
+
+/* join two subtrees, every member of left < mid < every member of right.
+ * descend the taller one's inner spine to a subtree of matching height,
+ * hang mid there and rebalance on the way back up */
+static node_t* Join(avl_t* tree, node_t* left, node_t* mid, node_t* right)
+{
+	if (Height(left) > Height(right) + 1)
+	{
+		left->side[1] = Join(tree, left->side[1], mid, right);
+		return Rebalance(tree, left);
+	}
+	if (Height(right) > Height(left) + 1)
+	{
+		right->side[0] = Join(tree, left, mid, right->side[0]);
+		return Rebalance(tree, right);
+	}
+	mid->side[0] = left;
+	mid->side[1] = right;
+	UpdateHeight(mid);
+	return mid;
+}
+
+/* join without a middle node: the maximum of left takes that role */
+static node_t* Join2(avl_t* tree, node_t* left, node_t* right)
+{
+	node_t* last = NULL;
+
+	if (!left)
+		return right;
+	left = SplitLast(tree, left, &last);
+	return Join(tree, left, last, right);
+}
+
+/* detach the maximum node of a subtree */
+static node_t* SplitLast(avl_t* tree, node_t* node, node_t** last)
+{
+	if (!node->side[1])
+	{
+		*last = node;
+		return node->side[0];
+	}
+	node->side[1] = SplitLast(tree, node->side[1], last);
+	return Rebalance(tree, node);
+}
+
+/* split a subtree into members < data, the member equal to data (detached,
+ * or NULL) and members > data */
+static void Split(avl_t* tree, node_t* node, const void* data, uint32_t key,
+                  node_t** left, node_t** found, node_t** right)
+{
+	int cmp_res = 0;
+
+	if (!node)
+	{
+		*left = *found = *right = NULL;
+		return;
+	}
+	cmp_res = Compare(tree, data, key, node);
+	if (cmp_res == 0)
+	{
+		*left = node->side[0];
+		*right = node->side[1];
+		*found = node;
+	}
+	else if (cmp_res < 0)
+	{
+		Split(tree, node->side[0], data, key, left, found, right);
+		*right = Join(tree, *right, node, node->side[1]);
+	}
+	else
+	{
+		Split(tree, node->side[1], data, key, left, found, right);
+		*left = Join(tree, node->side[0], node, *left);
+	}
+}
+
+/* copy a subtree of another tree with this tree's allocator. members that
+ * can't be allocated are left out */
+static node_t* CopyRec(avl_t* tree, const node_t* node, int* status)
+{
+	node_t* left = NULL;
+	node_t* right = NULL;
+	node_t* copy = NULL;
+
+	if (!node)
+		return NULL;
+	left = CopyRec(tree, node->side[0], status);
+	right = CopyRec(tree, node->side[1], status);
+	copy = NewNode(tree, node->data);
+	if (!copy)
+	{
+		*status = -1;
+		return Join2(tree, left, right);
+	}
+	copy->side[0] = left;
+	copy->side[1] = right;
+	UpdateHeight(copy);
+	return copy;
+}
+
+/* t1 | t2: split t1 around the root of t2 and recurse on both halves */
+static node_t* UnionRec(avl_t* tree, node_t* t1, const node_t* t2, int* status)
+{
+	node_t* left = NULL;
+	node_t* mid = NULL;
+	node_t* right = NULL;
+
+	if (!t2)
+		return t1;
+	if (!t1)
+		return CopyRec(tree, t2, status);
+	Split(tree, t1, t2->data, KeyOf(tree, t2->data), &left, &mid, &right);
+	left = UnionRec(tree, left, t2->side[0], status);
+	right = UnionRec(tree, right, t2->side[1], status);
+	if (!mid)
+	{
+		mid = NewNode(tree, t2->data);
+		if (!mid)
+		{
+			*status = -1;
+			return Join2(tree, left, right);
+		}
+	}
+	return Join(tree, left, mid, right);
+}
+
+/* t1 & t2: keep the t1 node matching the root of t2, if any */
+static node_t* IntersectRec(avl_t* tree, node_t* t1, const node_t* t2)
+{
+	node_t* left = NULL;
+	node_t* mid = NULL;
+	node_t* right = NULL;
+
+	if (!t1)
+		return NULL;
+	if (!t2)
+	{
+		FreeRec(tree, t1);
+		return NULL;
+	}
+	Split(tree, t1, t2->data, KeyOf(tree, t2->data), &left, &mid, &right);
+	left = IntersectRec(tree, left, t2->side[0]);
+	right = IntersectRec(tree, right, t2->side[1]);
+	if (mid)
+		return Join(tree, left, mid, right);
+	return Join2(tree, left, right);
+}
+
+/* t1 - t2: drop the t1 node matching the root of t2, if any */
+static node_t* DifferenceRec(avl_t* tree, node_t* t1, const node_t* t2)
+{
+	node_t* left = NULL;
+	node_t* mid = NULL;
+	node_t* right = NULL;
+
+	if (!t1 || !t2)
+		return t1;
+	Split(tree, t1, t2->data, KeyOf(tree, t2->data), &left, &mid, &right);
+	left = DifferenceRec(tree, left, t2->side[0]);
+	right = DifferenceRec(tree, right, t2->side[1]);
+	if (mid)
+		FreeNode(tree, mid);
+	return Join2(tree, left, right);
+}
+
+/* hand every chunk and free node of src over to dest. dest's newest chunk
+ * stays first, as its used count refers to it */
+static void MergePool(pool_t* dest, pool_t* src)
+{
+	chunk_t** chunk_tail = &dest->chunks;
+	node_t** free_tail = &dest->free_list;
+
+	while (*chunk_tail)
+		chunk_tail = &(*chunk_tail)->next;
+	*chunk_tail = src->chunks;
+	while (*free_tail)
+		free_tail = &(*free_tail)->side[0];
+	*free_tail = src->free_list;
+
+	src->chunks = NULL;
+	src->free_list = NULL;
+	src->used = src->chunk_nodes;
+}
+
+/* ============================= INSERT HELPER ============================= */
+
+/* iterative insert: record the links walked from the root, then retrace.
+ * works on a private root that EndWrite publishes */
+static int InsertIter(avl_t* tree, void* data)
+{
+	node_t** path[AVL_MAX_HEIGHT];
+	size_t depth = 0;
+	node_t* root = tree->root;
+	node_t** link = &root;
+	node_t* node = NULL;
+	uint32_t key = KeyOf(tree, data);
+	int cmp_res = 0;
+
+	if (BeginWrite(tree))
+		return -1;
+	while (*link)
+	{
+		cmp_res = Compare(tree, data, key, *link);
+		if (cmp_res == 0)
+		{
+			/* duplicates only join the key's group in a multiset */
+			AbortWrite(tree, path, depth);
+			return tree->multi ? AppendValue(*link, data) : -1;
+		}
+		*link = Own(tree, *link);
+		path[depth++] = link;
+		link = &(*link)->side[cmp_res > 0];
+	}
+	node = NewNode(tree, data);
+	if (!node)
+	{
+		AbortWrite(tree, path, depth);
+		return -1;
+	}
+	*link = node;
+	Retrace(tree, path, depth);
+	EndWrite(tree, root, tree->count + 1);
+	return 0;
+}
+
+/* ============================ GENERAL HELPERS ============================ */
+
+/* create new node, from the tree's pool if it has one */
+static node_t* NewNode(avl_t* tree, void* data)
+{
+	pool_t* pool = &tree->pool;
+	node_t* node = NULL;
+
+	if (!pool->chunk_nodes)
+	{
+		node = malloc(sizeof(node_t));
+	}
+	else if (pool->free_list)
+	{
+		node = pool->free_list;
+		pool->free_list = node->side[0];
+	}
+	else
+	{
+		if (pool->used == pool->chunk_nodes)
+		{
+			if (!NewChunk(pool, pool->chunk_nodes))
+				return NULL;
+			pool->used = 0;
+		}
+		node = &pool->chunks->nodes[pool->used++];
+	}
+	if (!node)
+		return NULL;
+	node->side[0] = node->side[1] = NULL;
+	node->data = data;
+	node->key = KeyOf(tree, data);
+	node->height = 1;
+	node->size = 1;
+	node->extra.birth = tree->version;
+	node->grouped = 0;
+	AVL_STAT_ADD(tree, allocations, 1);
+	return node;
+}
+
+/* build a perfectly balanced subtree of items[lo, hi), node i at nodes[i] */
+static node_t* BuildRec(node_t* nodes, void** items, size_t lo, size_t hi)
+{
+	size_t mid = lo + (hi - lo) / 2;
+	node_t* node = NULL;
+
+	if (lo >= hi)
+		return NULL;
+	node = &nodes[mid];
+	node->data = items[mid];
+	node->key = 0;
+	node->grouped = 0;
+	node->side[0] = BuildRec(nodes, items, lo, mid);
+	node->side[1] = BuildRec(nodes, items, mid + 1, hi);
+	UpdateHeight(node);
+	return node;
+}
+
+/* release a node, back to the pool's free list if the tree has one */
+static void FreeNode(avl_t* tree, node_t* node)
+{
+	if (node->grouped)
+	{
+		free(node->extra.group);
+		node->grouped = 0;
+	}
+	if (!tree->pool.chunk_nodes)
+	{
+		free(node);
+		return;
+	}
+	node->side[0] = tree->pool.free_list;
+	tree->pool.free_list = node;
+}
+
+/* allocate a chunk of the given number of nodes and make it the newest */
+static chunk_t* NewChunk(pool_t* pool, size_t nodes)
+{
+	chunk_t* chunk = malloc(sizeof(chunk_t) + nodes * sizeof(node_t));
+	if (!chunk)
+		return NULL;
+	chunk->next = pool->chunks;
+	pool->chunks = chunk;
+	return chunk;
+}
+
+/* make sure the next nodes NewNode hands out need no allocation. what is
+ * left of the current chunk moves to the free list if it is too small */
+static int Reserve(pool_t* pool, size_t nodes)
+{
+	node_t* node = NULL;
+
+	if (pool->chunk_nodes - pool->used >= nodes)
+		return 0;
+	while (pool->used < pool->chunk_nodes)
+	{
+		node = &pool->chunks->nodes[pool->used++];
+		node->side[0] = pool->free_list;
+		pool->free_list = node;
+	}
+	if (!NewChunk(pool, pool->chunk_nodes))
+		return -1;
+	pool->used = 0;
+	return 0;
+}
+
+/* free every chunk - the nodes go with them, no per-node walk needed */
+static void DestroyPool(pool_t* pool)
+{
+	chunk_t* next = NULL;
+
+	while (pool->chunks)
+	{
+		next = pool->chunks->next;
+		free(pool->chunks);
+		pool->chunks = next;
+	}
+	pool->free_list = NULL;
+}
+
+/* walk the recorded path bottom-up, rebalancing until a subtree height stops
+ * changing - the ancestors above it only need their sizes fixed */
+static void Retrace(avl_t* tree, node_t** path[], size_t depth)
+{
+	node_t* node = NULL;
+	size_t old_height = 0;
+
+	while (depth > 0)
+	{
+		node = *path[--depth];
+		old_height = node->height;
+		node = Rebalance(tree, node);
+		*path[depth] = node;
+		if (node->height == old_height)
+			break;
+	}
+	while (depth > 0)
+	{
+		node = *path[--depth];
+		node->size = Size(node->side[0]) + Size(node->side[1]) + 1;
+	}
+}
+
+/* rebalance subtree. node must already be owned by the current update */
+static node_t* Rebalance(avl_t* tree, node_t* node)
+{
+	int bf = 0;
+	UpdateHeight(node);
+	bf = BalanceFactor(node);
+	if (bf > 1)
+	{
+		/* right-heavy */
+		if (BalanceFactor(node->side[1]) < 0)
+		{
+			/* RL case */
+			node->side[1] = Rotate(tree, Own(tree, node->side[1]), 1);
+			AVL_STAT_ADD(tree, double_rotations, 1);
+		}
+		else
+		{
+			AVL_STAT_ADD(tree, single_rotations, 1);
+		}
+		/* RR case */
+		return Rotate(tree, node, 0);
+	}
+	if (bf < -1)
+	{
+		/* left-heavy */
+		if (BalanceFactor(node->side[0]) > 0)
+		{
+			/* LR case */
+			node->side[0] = Rotate(tree, Own(tree, node->side[0]), 0);
+			AVL_STAT_ADD(tree, double_rotations, 1);
+		}
+		else
+		{
+			AVL_STAT_ADD(tree, single_rotations, 1);
+		}
+		/* LL case */
+		return Rotate(tree, node, 1);
+	}
+	return node;
+}
+
+/* helper: update height and size of node from children */
+static void UpdateHeight(node_t* node)
+{
+	size_t lh = Height(node->side[0]);
+	size_t rh = Height(node->side[1]);
+	node->height = (unsigned char) ((lh > rh ? lh : rh) + 1);
+	node->size = Size(node->side[0]) + Size(node->side[1]) + 1;
+}
+
+/* helper: get subtree size of node (0 if null) */
+static size_t Size(const node_t* node)
+{
+	return node ? node->size : 0;
+}
+
+/* helper: get height of node (0 if null) */
+static size_t Height(node_t* node)
+{
+	return node ? node->height : 0;
+}
+
+/* helper: get balance factor = right height - left height */
+static int BalanceFactor(node_t* n)
+{
+	return (int) Height(n->side[1]) - (int) Height(n->side[0]);
+}
+
+/* single rotation: dir = 0 => right rotation; dir = 1 => left rotation.
+ * root must already be owned; the pivot is taken over here */
+static node_t* Rotate(avl_t* tree, node_t* root, int dir)
+{
+	int opp = dir ^ 1;
+	node_t* pivot = Own(tree, root->side[opp]);
+	root->side[opp] = pivot->side[dir];
+	pivot->side[dir] = root;
+	UpdateHeight(root);
+	UpdateHeight(pivot);
+	return pivot;
+}
+
+/* iterative removal: a node with two children takes its successor's data and
+ * the successor is unlinked instead, so only one link ever changes */
+static void RemoveIter(avl_t* tree, const void* data)
+{
+	node_t** path[AVL_MAX_HEIGHT];
+	size_t depth = 0;
+	node_t* root = tree->root;
+	node_t** link = &root;
+	node_t* target = NULL;
+	uint32_t key = KeyOf(tree, data);
+	int cmp_res = 0;
+
+	if (BeginWrite(tree))
+		return;
+	while (*link)
+	{
+		cmp_res = Compare(tree, data, key, *link);
+		if (cmp_res == 0)
+			break;
+		*link = Own(tree, *link);
+		path[depth++] = link;
+		link = &(*link)->side[cmp_res > 0];
+	}
+	if (!*link)
+	{
+		AbortWrite(tree, path, depth);
+		return;
+	}
+
+	target = *link;
+	if (target->side[0] && target->side[1])
+	{
+		/* two children: descend to the minimum of the right subtree */
+		target = *link = Own(tree, target);
+		path[depth++] = link;
+		link = &target->side[1];
+		while ((*link)->side[0])
+		{
+			*link = Own(tree, *link);
+			path[depth++] = link;
+			link = &(*link)->side[0];
+		}
+		target->data = (*link)->data;
+		target->key = (*link)->key;
+		if (tree->multi)
+		{
+			/* the successor's values move up, target's go with its node */
+			group_t* group = target->extra.group;
+			unsigned char grouped = target->grouped;
+			target->extra.group = (*link)->extra.group;
+			target->grouped = (*link)->grouped;
+			(*link)->extra.group = group;
+			(*link)->grouped = grouped;
+		}
+		target = *link;
+	}
+	*link = target->side[0] ? target->side[0] : target->side[1];
+	Discard(tree, target);
+	Retrace(tree, path, depth);
+	EndWrite(tree, root, tree->count - 1);
+}
+
+/* ========================== COPY-ON-WRITE HELPERS ========================== */
+
+/* start an update. on a copy-on-write tree every node it creates is stamped
+ * with a new version, and room for the nodes it copies and retires is set
+ * aside up front so it cannot fail half way */
+static int BeginWrite(avl_t* tree)
+{
+	cow_t* cow = tree->cow;
+	retired_t* grown = NULL;
+
+	if (!cow)
+		return 0;
+	if (Reserve(&tree->pool, AVL_WRITE_NODES))
+		return -1;
+	if (cow->retired_count + AVL_WRITE_NODES > cow->retired_cap)
+	{
+		Reclaim(tree);
+		/* snapshots pin what is left: grow before reclaiming every update */
+		if (cow->retired_count + AVL_WRITE_NODES > cow->retired_cap / 2)
+		{
+			grown = realloc(cow->retired, 2 * cow->retired_cap * sizeof(retired_t));
+			if (!grown)
+				return -1;
+			cow->retired = grown;
+			cow->retired_cap *= 2;
+		}
+	}
+	cow->retired_mark = cow->retired_count;
+	++tree->version;
+	return 0;
+}
+
+/* drop an update that turned out to change nothing. on a copy-on-write tree
+ * the path holds private copies: free them and forget what they replaced */
+static void AbortWrite(avl_t* tree, node_t** path[], size_t depth)
+{
+	if (!tree->cow)
+		return;
+	while (depth > 0)
+		FreeNode(tree, *path[--depth]);
+	tree->cow->retired_count = tree->cow->retired_mark;
+}
+
+/* make an update visible. concurrent readers pick up the new root
+ * atomically, and with it every node the update wrote */
+static void EndWrite(avl_t* tree, node_t* root, size_t count)
+{
+	__atomic_store_n(&tree->count, count, __ATOMIC_RELAXED);
+	if (!tree->cow || !tree->cow->concurrent)
+	{
+		tree->root = root;
+		return;
+	}
+	__atomic_store_n(&tree->root, root, __ATOMIC_SEQ_CST);
+}
+
+/* get a node the current update may change. on a copy-on-write tree a node
+ * from an earlier version may be shared, so it is copied and retired */
+static node_t* Own(avl_t* tree, node_t* node)
+{
+	node_t* copy = NULL;
+
+	if (!tree->cow || node->extra.birth == tree->version)
+		return node;
+	/* can't fail: BeginWrite reserved the nodes */
+	copy = NewNode(tree, node->data);
+	copy->side[0] = node->side[0];
+	copy->side[1] = node->side[1];
+	copy->height = node->height;
+	copy->size = node->size;
+	Retire(tree, node);
+	return copy;
+}
+
+/* release an unlinked node, deferred while it may still be shared */
+static void Discard(avl_t* tree, node_t* node)
+{
+	if (tree->cow && node->extra.birth != tree->version)
+		Retire(tree, node);
+	else
+		FreeNode(tree, node);
+}
+
+/* queue a node for Reclaim. BeginWrite made room for it */
+static void Retire(avl_t* tree, node_t* node)
+{
+	retired_t* retired = &tree->cow->retired[tree->cow->retired_count++];
+	retired->node = node;
+	retired->version = tree->version;
+}
+
+/* whether a live snapshot can still reach a retired node: it was created at
+ * or before the snapshot and unlinked after it */
+static int IsPinned(const cow_t* cow, const retired_t* retired)
+{
+	const avl_t* snapshot = NULL;
+
+	for (snapshot = cow->snapshots; snapshot; snapshot = snapshot->next)
+	{
+		if (retired->node->extra.birth <= snapshot->version &&
+		    snapshot->version < retired->version)
+			return 1;
+	}
+	return 0;
+}
+
+/* recycle every retired node no snapshot needs. in concurrent mode first wait
+ * until no reader can be inside a version that still links one. the epoch is
+ * flipped twice: a reader that read the parity just before one flip is
+ * caught by the wait on the other */
+static void Reclaim(avl_t* tree)
+{
+	cow_t* cow = tree->cow;
+	unsigned parity = 0;
+	size_t kept = 0;
+	size_t i = 0;
+	int flip = 0;
+	int stripe = 0;
+
+	for (flip = 0; cow->concurrent && flip < 2; ++flip)
+	{
+		parity = __atomic_fetch_add(&cow->epoch, 1, __ATOMIC_SEQ_CST) & 1;
+		for (stripe = 0; stripe < AVL_READER_STRIPES; ++stripe)
+		{
+			while (__atomic_load_n(&cow->readers[parity][stripe].count,
+			                       __ATOMIC_SEQ_CST))
+				sched_yield();
+		}
+	}
+	for (i = 0; i < cow->retired_count; ++i)
+	{
+		if (IsPinned(cow, &cow->retired[i]))
+			cow->retired[kept++] = cow->retired[i];
+		else
+			FreeNode(tree, cow->retired[i].node);
+	}
+	cow->retired_count = kept;
+}
+
+/* announce a reader in concurrent mode. returns the counter to pass to
+ * ExitRead, NULL for any other tree. never blocks */
+static size_t* EnterRead(const avl_t* tree)
+{
+	static unsigned next_stripe = 0;
+	static __thread unsigned stripe = 0; /* 0 - not assigned yet */
+	size_t* counter = NULL;
+	unsigned parity = 0;
+
+	if (!tree->cow || !tree->cow->concurrent)
+		return NULL;
+	if (!stripe)
+		stripe = __atomic_add_fetch(&next_stripe, 1, __ATOMIC_RELAXED);
+	parity = __atomic_load_n(&tree->cow->epoch, __ATOMIC_SEQ_CST) & 1;
+	counter = &tree->cow->readers[parity][stripe % AVL_READER_STRIPES].count;
+	__atomic_add_fetch(counter, 1, __ATOMIC_SEQ_CST);
+	return counter;
+}
+
+/* leave a read section started by EnterRead */
+static void ExitRead(size_t* counter)
+{
+	if (counter)
+		__atomic_sub_fetch(counter, 1, __ATOMIC_RELEASE);
+}
+
+/* current root. in concurrent mode it is published by EndWrite */
+static node_t* Root(const avl_t* tree)
+{
+	if (!tree->cow || !tree->cow->concurrent)
+		return tree->root;
+	return __atomic_load_n(&tree->root, __ATOMIC_SEQ_CST);
+}
+
+/* serialize updates and snapshot changes of a concurrent tree */
+static void LockWrites(const avl_t* tree)
+{
+	if (tree->cow && tree->cow->concurrent)
+		pthread_mutex_lock(&tree->cow->write_lock);
+}
+
+static void UnlockWrites(const avl_t* tree)
+{
+	if (tree->cow && tree->cow->concurrent)
+		pthread_mutex_unlock(&tree->cow->write_lock);
+}
+
+/* create a tree whose updates copy shared nodes instead of changing them */
+static avl_t* CreateCow(avl_cmp_t sorting_method, int concurrent)
+{
+	avl_t* tree = AVLCreateWithPool(sorting_method, 0);
+	cow_t* cow = NULL;
+
+	if (!tree)
+		return NULL;
+
+	/* a whole update must fit in the chunk Reserve opens */
+	assert(tree->pool.chunk_nodes >= AVL_WRITE_NODES);
+
+	cow = calloc(1, sizeof(cow_t));
+	if (!cow)
+	{
+		AVLDestroy(tree);
+		return NULL;
+	}
+	cow->concurrent = concurrent;
+	cow->retired_cap = AVL_RETIRE_BATCH;
+	cow->retired = malloc(cow->retired_cap * sizeof(retired_t));
+	if (!cow->retired || pthread_mutex_init(&cow->write_lock, NULL))
+	{
+		free(cow->retired);
+		free(cow);
+		AVLDestroy(tree);
+		return NULL;
+	}
+	tree->cow = cow;
+	return tree;
+}
+
+/* unregister a snapshot and recycle the nodes only it was holding */
+static void ReleaseSnapshot(avl_t* snapshot)
+{
+	avl_t* tree = snapshot->origin;
+	avl_t** link = NULL;
+
+	LockWrites(tree);
+	for (link = &tree->cow->snapshots; *link != snapshot; link = &(*link)->next)
+		;
+	*link = snapshot->next;
+	Reclaim(tree);
+	UnlockWrites(tree);
+	free(snapshot);
+}
+
+/* recursive for-each (in-order) */
+static int ForEachRec(node_t* node, avl_op_t op, void* arg)
+{
+	int res = 0;
+	if (!node)
+		return 0;
+	res = ForEachRec(node->side[0], op, arg);
+	if (res)
+		return res;
+	res = Visit(node, op, arg);
+	if (res)
+		return res;
+	return ForEachRec(node->side[1], op, arg);
+}
+
+/* ============================ PARALLEL HELPERS ============================ */
+
+/* cut the tree into tasks, run them on the caller and threads - 1 workers,
+ * then reduce the parts in tree order */
+static int RunParallel(avl_t* tree, avl_op_t op, void* arg, size_t part_size,
+                       avl_reduce_t reduce, size_t threads)
+{
+	worker_t* workers = NULL;
+	char* parts = NULL;
+	size_t* reader = NULL;
+	node_t* root = NULL;
+	job_t job;
+	size_t ntasks = 0;
+	size_t grain = 0;
+	size_t i = 0;
+	int status = -1;
+
+	if (!threads)
+	{
+		long online = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = online > 0 ? (size_t) online : 1;
+	}
+	/* one read section covers every worker's traversal */
+	reader = EnterRead(tree);
+	root = Root(tree);
+	grain = Size(root) / (threads * AVL_TASKS_PER_THREAD);
+	if (grain < AVL_TASK_MIN)
+		grain = AVL_TASK_MIN;
+	ntasks = CollectTasks(root, grain, NULL, 0);
+
+	memset(&job, 0, sizeof(job));
+	job.tasks = calloc(ntasks + 1, sizeof(task_t));
+	job.deques = malloc(threads * sizeof(deque_t));
+	workers = malloc(threads * sizeof(worker_t));
+	if (part_size)
+		parts = calloc(ntasks + 1, part_size);
+	if (job.tasks && job.deques && workers && (parts || !part_size))
+	{
+		CollectTasks(root, grain, job.tasks, 0);
+		job.workers = threads;
+		job.op = op;
+		job.arg = arg;
+		job.part_size = part_size;
+		for (i = 0; part_size && i < ntasks; ++i)
+			job.tasks[i].part = parts + i * part_size;
+		for (i = 0; i < threads; ++i)
+		{
+			/* contiguous shares, so an undisturbed worker walks in order */
+			pthread_mutex_init(&job.deques[i].lock, NULL);
+			job.deques[i].head = ntasks * i / threads;
+			job.deques[i].tail = ntasks * (i + 1) / threads;
+			workers[i].job = &job;
+			workers[i].id = i;
+		}
+
+		/* a worker that fails to start leaves its share to the thieves */
+		for (i = 1; i < threads; ++i)
+		{
+			if (pthread_create(&workers[i].thread, NULL, Worker, &workers[i]))
+				workers[i].job = NULL;
+		}
+		Worker(&workers[0]);
+		for (i = 1; i < threads; ++i)
+		{
+			if (workers[i].job)
+				pthread_join(workers[i].thread, NULL);
+		}
+		for (i = 0; i < threads; ++i)
+			pthread_mutex_destroy(&job.deques[i].lock);
+
+		status = 0;
+		for (i = 0; i < ntasks && !status; ++i)
+			status = job.tasks[i].status;
+		for (i = 0; reduce && !status && i < ntasks; ++i)
+			reduce(arg, job.tasks[i].part);
+	}
+
+	ExitRead(reader);
+	free(parts);
+	free(workers);
+	free(job.deques);
+	free(job.tasks);
+	return status;
+}
+
+/* append the tasks of a subtree in tree order, returns the new task count.
+ * with NULL tasks only counts */
+static size_t CollectTasks(node_t* node, size_t grain, task_t* tasks,
+                           size_t n)
+{
+	if (!node)
+		return n;
+	if (node->size <= grain)
+	{
+		if (tasks)
+		{
+			tasks[n].node = node;
+			tasks[n].whole = 1;
+		}
+		return n + 1;
+	}
+	n = CollectTasks(node->side[0], grain, tasks, n);
+	if (tasks)
+	{
+		tasks[n].node = node;
+		tasks[n].whole = 0;
+	}
+	return CollectTasks(node->side[1], grain, tasks, n + 1);
+}
+
+/* run tasks until none is left anywhere or an op has failed */
+static void* Worker(void* arg)
+{
+	worker_t* worker = (worker_t*) arg;
+	job_t* job = worker->job;
+	task_t* task = NULL;
+	void* op_arg = NULL;
+	size_t k = 0;
+
+	while (!__atomic_load_n(&job->stop, __ATOMIC_RELAXED) &&
+	       TakeTask(job, worker->id, &k))
+	{
+		task = &job->tasks[k];
+		op_arg = job->part_size ? task->part : job->arg;
+		if (task->whole)
+			task->status = ForEachRec(task->node, job->op, op_arg);
+		else
+			task->status = Visit(task->node, job->op, op_arg);
+		if (task->status)
+			__atomic_store_n(&job->stop, 1, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+/* next task from the worker's own share, or stolen from another's tail */
+static int TakeTask(job_t* job, size_t id, size_t* task)
+{
+	deque_t* deque = NULL;
+	size_t i = 0;
+	int found = 0;
+
+	for (i = 0; i < job->workers && !found; ++i)
+	{
+		deque = &job->deques[(id + i) % job->workers];
+		pthread_mutex_lock(&deque->lock);
+		if (deque->head < deque->tail)
+		{
+			*task = i ? --deque->tail : deque->head++;
+			found = 1;
+		}
+		pthread_mutex_unlock(&deque->lock);
+	}
+	return found;
+}
+
+/* apply op to the node's data, or to every value of a multiset key */
+static int Visit(node_t* node, avl_op_t op, void* arg)
+{
+	size_t i = 0;
+	int res = 0;
+
+	if (!node->grouped)
+		return op(node->data, arg);
+	for (i = 0; i < node->extra.group->count && !res; ++i)
+		res = op(node->extra.group->values[i], arg);
+	return res;
+}
+
+/* recursive for-each (in-order) restricted to [lo, hi]. subtrees entirely
+ * outside the range are never entered */
+static int ForEachRangeRec(const avl_t* tree, node_t* node, const void* lo,
+                           uint32_t lo_key, const void* hi, uint32_t hi_key,
+                           avl_op_t op, void* arg)
+{
+	int res = 0;
+	int after_lo = 0;
+	int before_hi = 0;
+
+	if (!node)
+		return 0;
+	after_lo = Compare(tree, lo, lo_key, node) <= 0;
+	before_hi = Compare(tree, hi, hi_key, node) >= 0;
+	if (after_lo)
+	{
+		res = ForEachRangeRec(tree, node->side[0], lo, lo_key, hi, hi_key, op,
+		                      arg);
+		if (res)
+			return res;
+	}
+	if (after_lo && before_hi)
+	{
+		res = Visit(node, op, arg);
+		if (res)
+			return res;
+	}
+	if (before_hi)
+		return ForEachRangeRec(tree, node->side[1], lo, lo_key, hi, hi_key,
+		                       op, arg);
+	return 0;
+}
+
+/* smallest member >= data, or > data when strict */
+static void* Bound(const avl_t* tree, const void* data, int strict)
+{
+	const node_t* node = NULL;
+	size_t* reader = NULL;
+	void* best = NULL;
+	uint32_t key = 0;
+	int cmp_res = 0;
+
+	if (!tree || !tree->cmp_func)
+		return NULL;
+	key = KeyOf(tree, data);
+	reader = EnterRead(tree);
+	node = Root(tree);
+	while (node)
+	{
+		cmp_res = Compare(tree, data, key, node);
+		if (cmp_res < 0 || (cmp_res == 0 && !strict))
+		{
+			best = node->data;
+			node = node->side[0];
+		}
+		else
+		{
+			node = node->side[1];
+		}
+	}
+	ExitRead(reader);
+	return best;
+}
+
+/* push node and then its dir-most descendants onto the iterator path */
+static void IterDescend(avl_iter_t* iter, node_t* node, int dir)
+{
+	while (node)
+	{
+		iter->path[iter->depth++] = node;
+		node = node->side[dir];
+	}
+}
+
+/* move to the in-order neighbour: dir = 1 => next; dir = 0 => previous */
+static void IterStep(avl_iter_t* iter, int dir)
+{
+	node_t* node = NULL;
+
+	if (!iter->depth)
+	{
+		/* stepping back from end lands on the maximum */
+		if (!dir && iter->tree)
+			IterDescend(iter, iter->tree->root, 1);
+		return;
+	}
+	node = iter->path[iter->depth - 1];
+	if (node->side[dir])
+	{
+		IterDescend(iter, node->side[dir], !dir);
+		return;
+	}
+	/* climb while we are coming up from the dir side */
+	do
+	{
+		node = iter->path[--iter->depth];
+	} while (iter->depth && iter->path[iter->depth - 1]->side[dir] == node);
+}
+
+/* fill the Eytzinger subtree rooted at k from an in-order iterator */
+static void FreezeRec(avl_frozen_t* frozen, avl_iter_t* iter, size_t k)
+{
+	if (k > frozen->count)
+		return;
+	FreezeRec(frozen, iter, 2 * k);
+	((void**) frozen->storage)[k - 1] = AVLIterGetData(iter);
+	AVLIterNext(iter);
+	FreezeRec(frozen, iter, 2 * k + 1);
+}
+
+/* index of the smallest item not less than data, 0 if there is none.
+ * the descent has no data dependent branch; the prefetch pulls in the line
+ * holding the 8 great-grandchildren of k */
+static size_t FrozenSearch(const avl_frozen_t* frozen, const void* data)
+{
+	size_t k = 1;
+
+	while (k <= frozen->count)
+	{
+		AVL_PREFETCH(frozen->base + (8 * k - 1) * frozen->stride);
+		k = 2 * k + (frozen->cmp_func(data, FrozenItem(frozen, k)) > 0);
+	}
+	/* undo the trailing right turns and the last left turn */
+	while (k & 1)
+		k >>= 1;
+	return k >> 1;
+}
+
+/* item k (1-based) of a frozen snapshot */
+static void* FrozenItem(const avl_frozen_t* frozen, size_t k)
+{
+	const char* item = frozen->base + (k - 1) * frozen->stride;
+	return frozen->indirect ? *(void* const*) item : (void*) item;
+}
+
+/* add a value to a multiset key, turning its node into a group if needed */
+static int AppendValue(node_t* node, void* data)
+{
+	group_t* group = node->grouped ? node->extra.group : NULL;
+	group_t* grown = NULL;
+	size_t cap = 0;
+
+	if (!group || group->count == group->cap)
+	{
+		cap = group ? group->cap * 2 : AVL_GROUP_MIN;
+		grown = realloc(group, sizeof(group_t) + cap * sizeof(void*));
+		if (!grown)
+			return -1;
+		if (!group)
+		{
+			grown->count = 1;
+			grown->values[0] = node->data;
+		}
+		grown->cap = cap;
+		group = node->extra.group = grown;
+		node->grouped = 1;
+	}
+	group->values[group->count++] = data;
+	return 0;
+}
+
+/* remove one value from a group of at least two, keeping insertion order */
+static int DropValue(node_t* node, const void* data)
+{
+	group_t* group = node->extra.group;
+	size_t i = 0;
+
+	while (i < group->count && group->values[i] != data)
+		++i;
+	if (i == group->count)
+		return -1;
+	for (--group->count; i < group->count; ++i)
+		group->values[i] = group->values[i + 1];
+	node->data = group->values[0];
+	if (group->count == 1)
+	{
+		free(group);
+		node->grouped = 0;
+	}
+	return 0;
+}
+
+/* find the node matching data below node */
+static node_t* FindNode(const avl_t* tree, node_t* node, const void* data,
+                        uint32_t key)
+{
+	size_t depth = 0;
+	int cmp_res = 0;
+
+	while (node)
+	{
+		++depth;
+		cmp_res = Compare(tree, data, key, node);
+		if (cmp_res == 0)
+			break;
+		node = node->side[cmp_res > 0];
+	}
+	AVL_STAT_ADD(tree, find_depth[depth], 1);
+	(void) depth;
+	return node;
+}
+
+/* prefix of data under the tree's prefix function */
+static uint32_t KeyOf(const avl_t* tree, const void* data)
+{
+	return tree->prefix_func ? tree->prefix_func(data) : 0;
+}
+
+/* compare data against a node: the inline keys decide unless they tie */
+static int Compare(const avl_t* tree, const void* data, uint32_t key,
+                   const node_t* node)
+{
+	if (key != node->key)
+		return key < node->key ? -1 : 1;
+	AVL_STAT_ADD(tree, comparisons, 1);
+	return tree->cmp_func(data, node->data);
 }
@@ -5,36 +5,104 @@
  *****************************************/
 
 #include "../include/c_hash_table.h"
-#include "../include/doubly_linked_list.h"
 
 #include <stdlib.h> /* malloc, free */
+#include <stdint.h> /* uint64_t */
 #include <assert.h> /* assert */
 #include <math.h>   /* sqrt */
-#include <stdio.h>  /* FILE, fopen, fgets, fclose */
+#include <string.h> /* memset, memchr, memcpy */
+#include <pthread.h>  /* pthread_create, pthread_join */
+#include <fcntl.h>    /* open */
+#include <unistd.h>   /* close */
+#include <sys/mman.h> /* mmap, munmap */
+#include <sys/stat.h> /* fstat */
 
 /* Linux dictionary path and max word size */
 #define LINUX_DIC "/home/shoval-elhaiany/Desktop/git/ds/src/words.txt"
 
+/* Old lists moved by each Insert and Remove while a resize is in progress */
+#define REHASH_STEP (4)
+
+/* 2^64 / golden ratio, for multiply-shift indexing of power of 2 sizes */
+#define FIBONACCI_MULTIPLIER (0x9E3779B97F4A7C15ULL)
+
+/* One element in a list. The table owns these, so a rehash can relink
+them into the new lists without allocating, and keeps the hash of data so
+neither a rehash nor a lookup has to call hash_func on it again */
+typedef struct hash_entry hash_entry_t;
+struct hash_entry
+{
+	hash_entry_t* next; /* Next entry in the same list */
+	size_t hash;        /* hash_func(data) */
+	void* data;         /* User data */
+};
+
+/* Words of a dictionary file, see LoadDicFile */
+struct dictionary
+{
+	char* words;     /* Private writable mapping of the file */
+	size_t map_size; /* Bytes mapped */
+	char* tail;      /* Copy of a last word with no newline after it */
+};
+
+/* Part of the entries LoadDicFile hashes on one thread */
+typedef struct hash_job
+{
+	hash_entry_t** entries;
+	size_t count;
+	hash_func_t hash_func;
+	pthread_t thread;
+	int started; /* 1 if thread has to be joined */
+} hash_job_t;
+
 /* Hash table structure definition */
 struct hash_table
 {
-	list_t** lists;        /* Array of pointers to doubly linked lists */
+	hash_entry_t** lists;  /* Array of singly linked lists */
+	size_t* lengths;       /* Elements in each list, after lists in memory */
 	size_t table_size;     /* Number of lists in the hash table */
+	unsigned shift;        /* 64 - log2(table_size), 0 to index by modulo */
+	int multiply_shift;    /* 1 if from CreatePow2, power of 2 sizes index
+	                          by multiply-shift */
+	hash_entry_t** old_lists; /* Lists being emptied into lists, or NULL */
+	size_t* old_lengths;   /* Elements in each old list */
+	size_t old_size;       /* Number of old lists */
+	unsigned old_shift;    /* shift of the old lists */
+	size_t migrated;       /* Old lists before this one are empty */
+	size_t min_size;       /* Size given to Create, shrinking stops there */
 	size_t num_elements;   /* Total number of elements stored */
+	double max_load;       /* Grow above this load, 0 for never */
+	double min_load;       /* Shrink below this load, 0 for never */
 	cmp_func_t cmp_func;   /* Comparison function pointer */
 	hash_func_t hash_func; /* Hash function pointer */
 };
 /*======================= DECLARATION OF HELPER FUNCS =======================*/
 
 void LoadDic(hash_table_t* hash_table);
+static hash_entry_t** FindLink(const hash_table_t* hashTable, const void* key,
+                               size_t** length);
+static hash_entry_t** FindInList(const hash_table_t* hashTable,
+                                 hash_entry_t** link, size_t hash,
+                                 const void* key);
+static int StartRehash(hash_table_t* hashTable, size_t newSize);
+static void FreeEntries(hash_entry_t** lists, size_t size);
+static hash_entry_t** CreateLists(size_t size);
+static void Link(hash_table_t* hashTable, hash_entry_t* entry);
+static int SplitWords(dictionary_t* dictionary, hash_entry_t** entries,
+                      size_t* count);
+static void HashAll(hash_entry_t** entries, size_t count,
+                    hash_func_t hash_func, size_t threads);
+static void* HashEntries(void* arg);
+static void AddLengths(const size_t* lengths, size_t size, hash_stats_t* stats,
+                       double* sum_of_squares);
+static unsigned ShiftFor(size_t size);
+static size_t ListIndex(size_t hash, size_t size, unsigned shift);
 
 /*================================ API FUNCS ================================*/
 
 hash_table_t* Create(cmp_func_t cmp_func, hash_func_t hash_func,
                      size_t hashTableSz)
 {
-	size_t i = 0;
-
 	/* Allocate memory for hash table structure */
 	hash_table_t* hash_table = (hash_table_t*) malloc(sizeof(hash_table_t));
 	if (NULL == hash_table)
@@ -45,8 +113,8 @@ hash_table_t* Create(cmp_func_t cmp_func, hash_func_t hash_func,
 	assert(NULL != hash_func);
 	assert(0 < hashTableSz);
 
-	/* Allocate memory for array of list pointers */
-	hash_table->lists = (list_t**) malloc(sizeof(list_t*) * hashTableSz);
+	/* Allocate the lists, all empty */
+	hash_table->lists = CreateLists(hashTableSz);
 	if (NULL == hash_table->lists)
 	{
 		free(hash_table);
@@ -54,28 +122,46 @@ hash_table_t* Create(cmp_func_t cmp_func, hash_func_t hash_func,
 	}
 
 	/* Initialize hash table fields */
+	hash_table->lengths = (size_t*) (hash_table->lists + hashTableSz);
 	hash_table->table_size = hashTableSz;
+	hash_table->shift = 0;
+	hash_table->multiply_shift = 0;
+	hash_table->old_lists = NULL;
+	hash_table->old_lengths = NULL;
+	hash_table->old_size = 0;
+	hash_table->old_shift = 0;
+	hash_table->migrated = 0;
+	hash_table->min_size = hashTableSz;
 	hash_table->num_elements = 0;
+	hash_table->max_load = 0;
+	hash_table->min_load = 0;
 	hash_table->cmp_func = cmp_func;
 	hash_table->hash_func = hash_func;
 
-	/* Create doubly linked list for each list */
-	for (i = 0; i < hashTableSz; ++i)
-	{
-		hash_table->lists[i] = create();
-		if (NULL == hash_table->lists[i])
-		{
-			/* Clean up previously created lists on failure */
-			while (0 < i)
-			{
-				--i;
-				destroy(hash_table->lists[i]);
-			}
-			free(hash_table->lists);
-			free(hash_table);
-			return NULL;
-		}
-	}
+	return hash_table;
+}
+
+/*===========================================================================*/
+
+hash_table_t* CreatePow2(cmp_func_t cmp_func, hash_func_t hash_func,
+                         size_t hashTableSz)
+{
+	size_t size = 1;
+	hash_table_t* hash_table = NULL;
+
+	/* Validate input parameters */
+	assert(0 < hashTableSz);
+
+	/* Round up to a power of 2 */
+	while (size < hashTableSz)
+		size <<= 1;
+
+	hash_table = Create(cmp_func, hash_func, size);
+	if (NULL == hash_table)
+		return NULL;
+
+	hash_table->shift = ShiftFor(size);
+	hash_table->multiply_shift = 1;
 
 	return hash_table;
 }
@@ -84,16 +170,16 @@ hash_table_t* Create(cmp_func_t cmp_func, hash_func_t hash_func,
 
 void Destroy(hash_table_t* hashTable)
 {
-	size_t i = 0;
+	if (NULL == hashTable)
+		return;
 
-	/* Validate input parameter */
-	assert(NULL != hashTable);
-
-	/* Destroy all list lists */
-	for (i = 0; i < hashTable->table_size; ++i)
-		destroy(hashTable->lists[i]);
+	/* Free the entries of every list, old and new */
+	if (NULL != hashTable->old_lists)
+		FreeEntries(hashTable->old_lists, hashTable->old_size);
+	FreeEntries(hashTable->lists, hashTable->table_size);
 
 	/* Free lists array and hash table structure */
+	free(hashTable->old_lists);
 	free(hashTable->lists);
 	free(hashTable);
 }
@@ -102,27 +188,28 @@ void Destroy(hash_table_t* hashTable)
 
 int Insert(hash_table_t* hashTable, void* data)
 {
-	size_t index = 0;
-	node_t* new_node = NULL;
+	hash_entry_t* entry = NULL;
 
 	/* Validate input parameters */
 	assert(NULL != hashTable);
 	assert(NULL != data);
 
-	/* Calculate list index using hash function */
-	index = hashTable->hash_func(data) % hashTable->table_size;
+	entry = (hash_entry_t*) malloc(sizeof(hash_entry_t));
+	if (NULL == entry)
+		return 1; /* Failure */
 
 	/* Insert data at the beginning of the appropriate list */
-	new_node =
-	    insert(hashTable->lists[index], end(hashTable->lists[index]), data);
-
-	/* Check if insertion was successful */
-	if (prev(end(hashTable->lists[index])) != new_node)
-	{
-		return 1; /* Failure */
-	}
-	/* Increment element count */
-	++hashTable->num_elements;
+	entry->hash = hashTable->hash_func(data);
+	entry->data = data;
+	Link(hashTable, entry);
+
+	/* Move a few old lists if resizing, else grow if too loaded. The
+	element is in either way, so a failed resize just leaves the table as
+	it is */
+	if (NULL != hashTable->old_lists)
+		RehashStep(hashTable, REHASH_STEP);
+	else if (0 < hashTable->max_load && Load(hashTable) > hashTable->max_load)
+		StartRehash(hashTable, hashTable->table_size * 2);
 
 	return 0; /* Success */
 }
@@ -131,25 +218,40 @@ int Insert(hash_table_t* hashTable, void* data)
 
 void Remove(hash_table_t* hashTable, const void* key)
 {
-	size_t index = 0;
-	node_t* node = NULL;
+	hash_entry_t** link = NULL;
+	hash_entry_t* entry = NULL;
+	size_t* length = NULL;
 
 	/* Validate input parameters */
 	assert(NULL != hashTable);
 	assert(NULL != key);
 
-	/* Calculate list index using hash function */
-	index = hashTable->hash_func(key) % hashTable->table_size;
+	/* Find the link to the entry to remove */
+	link = FindLink(hashTable, key, &length);
 
-	/* Find the node to remove in the specific list */
-	node = find(next(begin(hashTable->lists[index])),
-	            end(hashTable->lists[index]), hashTable->cmp_func, key);
-
-	/* Remove node if found */
-	if (node)
+	/* Remove entry if found */
+	if (NULL != *link)
 	{
-		removelist(node);
+		entry = *link;
+		*link = entry->next;
+		free(entry);
+		--*length;
 		--hashTable->num_elements;
+
+		/* Move a few old lists if resizing, else shrink if mostly empty,
+		but not below the created size */
+		if (NULL != hashTable->old_lists)
+		{
+			RehashStep(hashTable, REHASH_STEP);
+		}
+		else if (0 < hashTable->min_load &&
+		         Load(hashTable) < hashTable->min_load &&
+		         hashTable->table_size > hashTable->min_size)
+		{
+			StartRehash(hashTable, hashTable->table_size / 2 > hashTable->min_size
+			                      ? hashTable->table_size / 2
+			                      : hashTable->min_size);
+		}
 	}
 }
 
@@ -157,20 +259,17 @@ void Remove(hash_table_t* hashTable, const void* key)
 
 void* Find(const hash_table_t* hashTable, const void* key)
 {
-	size_t index = 0;
-	node_t* node = NULL;
-	node_t* debug;
+	hash_entry_t** link = NULL;
+
 	/* Validate input parameters */
 	assert(NULL != hashTable);
 	assert(NULL != key);
 
-	/* Calculate list index using hash function */
-	index = hashTable->hash_func(key) % hashTable->table_size;
-	/* Find the node in the specific list */
-	node = find(next(begin(hashTable->lists[index])),
-	            end(hashTable->lists[index]), hashTable->cmp_func, key);
+	/* Find the entry in the specific list */
+	link = FindLink(hashTable, key, NULL);
+
 	/* Return data if found */
-	return getdata(node);
+	return (NULL != *link) ? (*link)->data : NULL;
 }
 
 /*===========================================================================*/
@@ -199,21 +298,38 @@ int Foreach(const hash_table_t* hashTable, Action action, void* params)
 {
 	size_t i = 0;
 	int result = 0;
+	hash_entry_t* entry = NULL;
 
 	/* Validate input parameters */
 	assert(NULL != hashTable);
 	assert(NULL != action);
 
+	/* Old lists not yet moved hold elements too */
+	while (NULL != hashTable->old_lists && i < hashTable->old_size &&
+	       0 == result)
+	{
+		for (entry = hashTable->old_lists[i]; NULL != entry && 0 == result;
+		     entry = entry->next)
+		{
+			result = action(entry->data, params);
+		}
+		++i;
+	}
+
 	/* Iterate through all lists */
+	i = 0;
 	while (i < hashTable->table_size && 0 == result)
 	{
 		/* Apply action function to all elements in current list */
-		result = foreach (next(begin(hashTable->lists[i])),
-		                  end(hashTable->lists[i]), action, params);
+		for (entry = hashTable->lists[i]; NULL != entry && 0 == result;
+		     entry = entry->next)
+		{
+			result = action(entry->data, params);
+		}
 		++i;
 	}
 
-	return result;
+	return (0 != result);
 }
 
 /*================================= ADVANCED =================================*/
@@ -226,65 +342,545 @@ double Load(const hash_table_t* hashTable)
 	return (double) hashTable->num_elements / (double) hashTable->table_size;
 }
 
-// double SD(const hash_table_t* hashTable)
-// {
-// 	size_t i = 0;
-// 	double average = 0.0;
-// 	double sum_of_squares = 0.0;
-// 	double variance = 0.0;
-// 	size_t list_count = 0;
+/*===========================================================================*/
 
-// 	assert(NULL != hashTable);
+void SetLoadLimits(hash_table_t* hashTable, double max_load, double min_load)
+{
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(0 <= max_load);
+	assert(0 <= min_load);
+	assert(0 == max_load || min_load < max_load / 2);
 
-// 	/* Handle empty hash table */
-// 	if (0 == hashTable->num_elements)
-// 	{
-// 		return 0.0;
-// 	}
+	hashTable->max_load = max_load;
+	hashTable->min_load = min_load;
+}
 
-// 	/* Calculate average number of elements per list */
-// 	average = (double) hashTable->num_elements / (double) hashTable->table_size;
+/*===========================================================================*/
+
+int Rehash(hash_table_t* hashTable, size_t newSize)
+{
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(0 < newSize);
+
+	if (StartRehash(hashTable, newSize))
+		return 1; /* Failure, table unchanged */
+
+	/* Move everything now */
+	while (RehashStep(hashTable, hashTable->old_size))
+		;
+
+	return 0; /* Success */
+}
+
+/*===========================================================================*/
+
+int RehashStep(hash_table_t* hashTable, size_t steps)
+{
+	size_t empty_visits = steps * 10;
+	size_t index = 0;
+	hash_entry_t* entry = NULL;
+
+	/* Validate input parameter */
+	assert(NULL != hashTable);
+
+	if (NULL == hashTable->old_lists)
+		return 0;
+
+	/* Empty the next old lists into the new ones */
+	while (0 < steps && hashTable->migrated < hashTable->old_size)
+	{
+		entry = hashTable->old_lists[hashTable->migrated];
+		if (NULL == entry)
+		{
+			++hashTable->migrated;
+			if (0 == --empty_visits)
+				break;
+			continue;
+		}
+
+		hashTable->old_lists[hashTable->migrated] = entry->next;
+		--hashTable->old_lengths[hashTable->migrated];
+		index =
+		    ListIndex(entry->hash, hashTable->table_size, hashTable->shift);
+		entry->next = hashTable->lists[index];
+		hashTable->lists[index] = entry;
+		++hashTable->lengths[index];
+
+		/* A list counts as one step however long it is */
+		if (NULL == hashTable->old_lists[hashTable->migrated])
+		{
+			++hashTable->migrated;
+			--steps;
+		}
+	}
+
+	if (hashTable->migrated < hashTable->old_size)
+		return 1;
+
+	free(hashTable->old_lists);
+	hashTable->old_lists = NULL;
+	hashTable->old_lengths = NULL;
+	hashTable->old_size = 0;
+	hashTable->old_shift = 0;
+	hashTable->migrated = 0;
+
+	return 0;
+}
+
+double SD(const hash_table_t* hashTable)
+{
+	hash_stats_t stats;
+
+	/* Validate input parameter */
+	assert(NULL != hashTable);
+
+	/* Handle empty hash table */
+	if (0 == hashTable->num_elements)
+		return 0.0;
+
+	/* Return standard deviation normalized by hash size */
+	HashStats(hashTable, &stats);
+	return stats.sd / (double) hashTable->num_elements;
+}
+
+/*===========================================================================*/
+
+void HashStats(const hash_table_t* hashTable, hash_stats_t* stats)
+{
+	double sum_of_squares = 0.0;
+	double variance = 0.0;
+
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(NULL != stats);
 
-// 	/* Calculate sum of squared differences from average */
-// 	for (i = 0; i < hashTable->table_size; ++i)
-// 	{
-// 		list_count = count(hashTable->lists[i]);
-// 		sum_of_squares += (list_count - average) * (list_count - average);
-// 	}
+	memset(stats, 0, sizeof(hash_stats_t));
 
-// 	/* Calculate variance */
-// 	variance = sum_of_squares / (double) hashTable->table_size;
+	/* Count from the length counters, never walking a list. Old lists
+	already moved are gone, the rest still count */
+	AddLengths(hashTable->lengths, hashTable->table_size, stats,
+	           &sum_of_squares);
+	if (NULL != hashTable->old_lists)
+	{
+		AddLengths(hashTable->old_lengths + hashTable->migrated,
+		           hashTable->old_size - hashTable->migrated, stats,
+		           &sum_of_squares);
+	}
 
-// 	/* Return standard deviation normalized by hash size */
-// 	return sqrt(variance) / (double) hashTable->num_elements;
-// }
+	/* Variance as the mean of squares minus the squared mean */
+	stats->elements = hashTable->num_elements;
+	stats->average = (double) stats->elements / (double) stats->lists;
+	variance = sum_of_squares / (double) stats->lists -
+	           stats->average * stats->average;
+	stats->sd = (0.0 < variance) ? sqrt(variance) : 0.0;
+	stats->empty_ratio = (double) stats->empty / (double) stats->lists;
+}
 
 /*============================== HELPER FUNCS ==============================*/
 
+/* Link pointing at the first entry matching key, pointing at NULL if none.
+Old lists that haven't been moved yet are searched first. If length isn't
+NULL it is set to the length counter of the list the entry is in */
+static hash_entry_t** FindLink(const hash_table_t* hashTable, const void* key,
+                               size_t** length)
+{
+	size_t hash = hashTable->hash_func(key);
+	hash_entry_t** link = NULL;
+	size_t index = 0;
+
+	if (NULL != hashTable->old_lists)
+	{
+		index = ListIndex(hash, hashTable->old_size, hashTable->old_shift);
+		link = FindInList(hashTable, &hashTable->old_lists[index], hash, key);
+		if (NULL != *link)
+		{
+			if (NULL != length)
+				*length = &hashTable->old_lengths[index];
+			return link;
+		}
+	}
+
+	index = ListIndex(hash, hashTable->table_size, hashTable->shift);
+	if (NULL != length)
+		*length = &hashTable->lengths[index];
+	return FindInList(hashTable, &hashTable->lists[index], hash, key);
+}
+
+/*===========================================================================*/
+
+/* Walk one list from link. cmp_func only runs on entries with the same
+hash, so a miss rarely compares any keys */
+static hash_entry_t** FindInList(const hash_table_t* hashTable,
+                                 hash_entry_t** link, size_t hash,
+                                 const void* key)
+{
+	while (NULL != *link &&
+	       (hash != (*link)->hash || !hashTable->cmp_func((*link)->data, key)))
+	{
+		link = &(*link)->next;
+	}
+
+	return link;
+}
+
+/*===========================================================================*/
+
+/* Point lists at a new, empty array of newSize lists and keep the current
+one as the old lists, to be emptied by RehashStep. A resize already in
+progress is finished first */
+static int StartRehash(hash_table_t* hashTable, size_t newSize)
+{
+	hash_entry_t** new_lists = NULL;
+
+	new_lists = CreateLists(newSize);
+	if (NULL == new_lists)
+		return 1; /* Failure, table unchanged */
+
+	while (RehashStep(hashTable, hashTable->old_size))
+		;
+
+	hashTable->old_lists = hashTable->lists;
+	hashTable->old_lengths = hashTable->lengths;
+	hashTable->old_size = hashTable->table_size;
+	hashTable->old_shift = hashTable->shift;
+	hashTable->migrated = 0;
+	hashTable->lists = new_lists;
+	hashTable->lengths = (size_t*) (new_lists + newSize);
+	hashTable->table_size = newSize;
+	hashTable->shift = hashTable->multiply_shift ? ShiftFor(newSize) : 0;
+
+	return 0; /* Success */
+}
+
+/*===========================================================================*/
+
+/* Free every entry in size lists, not the array itself */
+static void FreeEntries(hash_entry_t** lists, size_t size)
+{
+	size_t i = 0;
+	hash_entry_t* entry = NULL;
+	hash_entry_t* next_entry = NULL;
+
+	for (i = 0; i < size; ++i)
+	{
+		for (entry = lists[i]; NULL != entry; entry = next_entry)
+		{
+			next_entry = entry->next;
+			free(entry);
+		}
+	}
+}
+
+/*===========================================================================*/
+
+/* size empty lists, with their length counters right after them in the
+same block */
+static hash_entry_t** CreateLists(size_t size)
+{
+	return (hash_entry_t**) calloc(size,
+	                               sizeof(hash_entry_t*) + sizeof(size_t));
+}
+
+/*===========================================================================*/
+
+/* Put an entry whose hash is set at the head of its list */
+static void Link(hash_table_t* hashTable, hash_entry_t* entry)
+{
+	size_t index =
+	    ListIndex(entry->hash, hashTable->table_size, hashTable->shift);
+
+	entry->next = hashTable->lists[index];
+	hashTable->lists[index] = entry;
+	++hashTable->lengths[index];
+
+	/* Increment element count */
+	++hashTable->num_elements;
+}
+
+/*===========================================================================*/
+
+/* Count size list lengths into stats, and their squares into
+sum_of_squares */
+static void AddLengths(const size_t* lengths, size_t size, hash_stats_t* stats,
+                       double* sum_of_squares)
+{
+	size_t i = 0;
+	size_t length = 0;
+
+	for (i = 0; i < size; ++i)
+	{
+		length = lengths[i];
+		++stats->histogram[length < HASH_HISTOGRAM_SIZE
+		                       ? length
+		                       : HASH_HISTOGRAM_SIZE - 1];
+		stats->empty += (0 == length);
+		stats->max_length =
+		    (length > stats->max_length) ? length : stats->max_length;
+		*sum_of_squares += (double) length * (double) length;
+	}
+	stats->lists += size;
+}
+
+/*===========================================================================*/
+
+/* For CreatePow2 tables: power of 2 sizes above 1 index by multiply-shift,
+the rest by modulo */
+static unsigned ShiftFor(size_t size)
+{
+	unsigned shift = 64;
+
+	if (1 >= size || 0 != (size & (size - 1)))
+		return 0;
+
+	while (1 < size)
+	{
+		size >>= 1;
+		--shift;
+	}
+
+	return shift;
+}
+
+/*===========================================================================*/
+
+/* List a hash belongs to. Multiply-shift takes the top bits of the product,
+which depend on every bit of the hash, so a hash whose low bits repeat (an
+identity hash of strided keys) still spreads. A multiplicative hash such as
+poly31 already mixes into the low bits, and multiplying again spreads it
+worse than modulo does */
+static size_t ListIndex(size_t hash, size_t size, unsigned shift)
+{
+	if (0 == shift)
+		return hash % size;
+
+	return (size_t) (((uint64_t) hash * FIBONACCI_MULTIPLIER) >> shift);
+}
+
+/*===========================================================================*/
+
 void LoadDic(hash_table_t* hash_table)
 {
-	/* Create a file pointer and open the for reading. */
-	FILE* file = fopen(LINUX_DIC, "r");
+	/* The words stay mapped for as long as the program runs */
+	dictionary_t* dictionary = LoadDicFile(hash_table, LINUX_DIC, 1);
+
+	/* Check if file is loaded successfully */
+	assert(dictionary != NULL);
+	(void) dictionary;
+}
+
+/*===========================================================================*/
+
+dictionary_t* LoadDicFile(hash_table_t* hash_table, const char* path,
+                          size_t threads)
+{
+	dictionary_t* dictionary = NULL;
+	hash_entry_t** entries = NULL;
+	struct stat info;
+	size_t max_words = 1;
+	size_t count = 0;
+	size_t size = 0;
+	size_t i = 0;
+	char* newline = NULL;
+	int fd = -1;
+
+	/* Validate input parameters */
+	assert(NULL != hash_table);
+	assert(NULL != path);
+
+	dictionary = (dictionary_t*) calloc(1, sizeof(dictionary_t));
+	fd = open(path, O_RDONLY);
+	if (NULL == dictionary || -1 == fd || fstat(fd, &info))
+		goto fail;
+
+	/* A private mapping: newlines become NULs in place, copied on write,
+	and the file is never read into a buffer of its own */
+	dictionary->map_size = (size_t) info.st_size;
+	if (0 < dictionary->map_size)
+	{
+		dictionary->words =
+		    (char*) mmap(NULL, dictionary->map_size, PROT_READ | PROT_WRITE,
+		                 MAP_PRIVATE, fd, 0);
+		if (MAP_FAILED == dictionary->words)
+		{
+			dictionary->words = NULL;
+			goto fail;
+		}
+	}
+	close(fd);
+	fd = -1;
+
+	/* Lines are at most newlines + 1; memchr scans a vector at a time */
+	for (newline = dictionary->words; NULL != newline; ++max_words)
+	{
+		newline = memchr(newline, '\n', dictionary->map_size -
+		                                     (newline - dictionary->words));
+		if (NULL != newline)
+			++newline;
+	}
+
+	/* One entry per word, all allocated before any is linked, so a failure
+	leaves the table untouched */
+	entries = (hash_entry_t**) calloc(max_words, sizeof(hash_entry_t*));
+	if (NULL == entries || SplitWords(dictionary, entries, &count))
+		goto fail;
+
+	HashAll(entries, count, hash_table->hash_func, threads);
+
+	/* Size the table for everything at once, then link it all. Without
+	the room the words would pile into the old lists, so that fails too */
+	size = hash_table->table_size;
+	while (size < hash_table->num_elements + count)
+		size *= 2;
+	if (size != hash_table->table_size && Rehash(hash_table, size))
+		goto fail;
+	for (i = 0; i < count; ++i)
+		Link(hash_table, entries[i]);
+
+	free(entries);
+	return dictionary;
+
+fail:
+	if (NULL != entries)
+	{
+		for (i = 0; i < max_words && NULL != entries[i]; ++i)
+			free(entries[i]);
+		free(entries);
+	}
+	if (-1 != fd)
+		close(fd);
+	FreeDic(dictionary);
+	return NULL;
+}
+
+/*===========================================================================*/
+
+void FreeDic(dictionary_t* dictionary)
+{
+	if (NULL == dictionary)
+		return;
+
+	if (NULL != dictionary->words)
+		munmap(dictionary->words, dictionary->map_size);
+	free(dictionary->tail);
+	free(dictionary);
+}
 
-	/* Buffer to store each word of the file. */
-	char word[MAX_WORD_SIZE];
+/*===========================================================================*/
 
-	/* Check if file is opened successfully */
-	assert(file != NULL);
+/* Cut the mapping into NUL terminated words, dropping a '\r' before each
+newline and skipping empty lines, and give each word an entry.
+Return value: 0 - for success, 1 - if an allocation failed */
+static int SplitWords(dictionary_t* dictionary, hash_entry_t** entries,
+                      size_t* count)
+{
+	char* line = dictionary->words;
+	char* end = dictionary->words + dictionary->map_size;
+	char* newline = NULL;
+	size_t length = 0;
 
-	/* Read each word from the file and store it in the 'word' buffer. */
-	while (fgets(word, MAX_WORD_SIZE, file))
+	*count = 0;
+	while (line < end)
 	{
-		word[strcspn(word, "\n")] = '\0';
+		newline = memchr(line, '\n', end - line);
+		length = (NULL != newline ? newline : end) - line;
+		if (0 < length && '\r' == line[length - 1])
+			--length;
 
-		char* dup = strdup(word);
-		if (dup == NULL)
+		if (NULL == newline && 0 < length)
 		{
-			continue;
+			/* No byte left in the mapping for a NUL, so copy the last word */
+			dictionary->tail = (char*) malloc(length + 1);
+			if (NULL == dictionary->tail)
+				return 1;
+			memcpy(dictionary->tail, line, length);
+			dictionary->tail[length] = '\0';
+			line = dictionary->tail;
 		}
-		Insert(hash_table, dup);
+		else
+		{
+			line[length] = '\0';
+		}
+
+		if (0 < length)
+		{
+			entries[*count] = (hash_entry_t*) malloc(sizeof(hash_entry_t));
+			if (NULL == entries[*count])
+				return 1;
+			entries[*count]->data = line;
+			++*count;
+		}
+
+		if (NULL == newline)
+			break;
+		line = newline + 1;
+	}
+
+	return 0;
+}
+
+/*===========================================================================*/
+
+/* Set the hash of count entries, spread over up to threads threads. The
+caller's thread takes the first share */
+static void HashAll(hash_entry_t** entries, size_t count,
+                    hash_func_t hash_func, size_t threads)
+{
+	hash_job_t* jobs = NULL;
+	hash_job_t single;
+	size_t share = 0;
+	size_t i = 0;
+
+	if (1 < threads && count >= threads)
+		jobs = (hash_job_t*) malloc(sizeof(hash_job_t) * threads);
+	if (NULL == jobs)
+	{
+		/* One thread, or no memory to plan more */
+		single.entries = entries;
+		single.count = count;
+		single.hash_func = hash_func;
+		HashEntries(&single);
+		return;
 	}
 
-	/* Close file. */
-	fclose(file);
+	share = (count + threads - 1) / threads;
+	for (i = 0; i < threads; ++i)
+	{
+		jobs[i].entries = entries + i * share;
+		jobs[i].count = (i * share < count) ? count - i * share : 0;
+		jobs[i].count = (jobs[i].count < share) ? jobs[i].count : share;
+		jobs[i].hash_func = hash_func;
+		jobs[i].started =
+		    0 < i && 0 == pthread_create(&jobs[i].thread, NULL, HashEntries,
+		                                 &jobs[i]);
+	}
+
+	/* Own share, plus any share whose thread didn't start */
+	for (i = 0; i < threads; ++i)
+	{
+		if (!jobs[i].started)
+			HashEntries(&jobs[i]);
+	}
+	for (i = 0; i < threads; ++i)
+	{
+		if (jobs[i].started)
+			pthread_join(jobs[i].thread, NULL);
+	}
+
+	free(jobs);
+}
+
+/*===========================================================================*/
+
+/* Thread body of HashAll */
+static void* HashEntries(void* arg)
+{
+	hash_job_t* job = (hash_job_t*) arg;
+	size_t i = 0;
+
+	for (i = 0; i < job->count; ++i)
+		job->entries[i]->hash = job->hash_func(job->entries[i]->data);
+
+	return NULL;
 }
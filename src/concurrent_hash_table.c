@@ -0,0 +1,595 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+#include "../include/concurrent_hash_table.h"
+
+#include <stdlib.h>  /* malloc, calloc, free */
+#include <stdint.h>  /* uint64_t */
+#include <assert.h>  /* assert */
+#include <sched.h>   /* sched_yield */
+#include <pthread.h> /* pthread_mutex_t */
+
+/* Writer locks, each owning 1/STRIPES of the lists */
+#define STRIPE_BITS (6)
+#define STRIPES (1 << STRIPE_BITS)
+
+/* Reader counters per epoch parity, spread so readers rarely share one */
+#define READER_STRIPES (32)
+#define CACHE_LINE (64)
+
+/* Removed entries a stripe collects before waiting for readers */
+#define RETIRE_BATCH (64)
+
+/* 2^64 / golden ratio: the top bits of hash * this pick the list, and the
+top STRIPE_BITS of those pick the stripe, whatever the number of lists */
+#define FIBONACCI_MULTIPLIER (0x9E3779B97F4A7C15ULL)
+
+/* One element in a list */
+typedef struct conc_entry conc_entry_t;
+struct conc_entry
+{
+	conc_entry_t* next;    /* Next entry in the same list, read by readers */
+	conc_entry_t* retired; /* Next removed entry waiting for readers */
+	size_t hash;           /* hash_func(data) */
+	void* data;            /* User data */
+};
+
+/* The lists, published through one pointer so a reader always sees a size
+that matches the array */
+typedef struct conc_lists
+{
+	size_t size;           /* Number of lists, a power of 2 */
+	unsigned shift;        /* 64 - log2(size) */
+	conc_entry_t* heads[]; /* First entry of each list */
+} conc_lists_t;
+
+/* Writer state of one range of lists, on cache lines of its own */
+typedef struct stripe
+{
+	pthread_mutex_t lock;  /* Held by Insert and Remove in this range */
+	size_t count;          /* Elements in this range */
+	conc_entry_t* retired; /* Removed entries, linked through retired */
+	size_t retired_count;  /* Length of retired */
+	char pad[CACHE_LINE - (sizeof(pthread_mutex_t) + 3 * sizeof(size_t)) %
+	                          CACHE_LINE];
+} stripe_t;
+
+/* Reader counter padded to a cache line of its own */
+typedef struct reader_slot
+{
+	size_t count;
+	char pad[CACHE_LINE - sizeof(size_t)];
+} reader_slot_t;
+
+/* Hash table structure definition. Readers announce themselves in the
+counters of the current epoch parity; a writer that frees memory flips the
+epoch and waits for the old parity to drain */
+struct concurrent_hash_table
+{
+	conc_lists_t* lists;      /* Current lists, replaced whole on growth */
+	stripe_t stripes[STRIPES];
+	reader_slot_t readers[2][READER_STRIPES];
+	unsigned epoch;
+	pthread_mutex_t reclaim_lock; /* One epoch flipper at a time */
+	cmp_func_t cmp_func;      /* Comparison function pointer */
+	hash_func_t hash_func;    /* Hash function pointer */
+};
+
+/*======================= DECLARATION OF HELPER FUNCS =======================*/
+
+static conc_lists_t* CreateLists(size_t size);
+static size_t ListIndex(const conc_lists_t* lists, size_t hash);
+static stripe_t* StripeOf(concurrent_hash_table_t* hashTable, size_t hash);
+static size_t* EnterRead(const concurrent_hash_table_t* hashTable);
+static void ExitRead(size_t* counter);
+static void WaitForReaders(concurrent_hash_table_t* hashTable);
+static void Grow(concurrent_hash_table_t* hashTable, size_t seen_size);
+static void FreeLists(conc_lists_t* lists);
+static void FreeRetired(conc_entry_t* entry);
+
+/*================================ API FUNCS ================================*/
+
+concurrent_hash_table_t* ConcurrentHashCreate(cmp_func_t cmp_func,
+                                              hash_func_t hash_func,
+                                              size_t capacity)
+{
+	concurrent_hash_table_t* hash_table = NULL;
+	size_t size = STRIPES;
+	int i = 0;
+
+	/* Validate input parameters */
+	assert(NULL != cmp_func);
+	assert(NULL != hash_func);
+
+	hash_table = (concurrent_hash_table_t*) calloc(
+	    1, sizeof(concurrent_hash_table_t));
+	if (NULL == hash_table)
+		return NULL;
+
+	/* Allocate the lists, all empty */
+	while (size < capacity)
+		size *= 2;
+	hash_table->lists = CreateLists(size);
+	if (NULL == hash_table->lists)
+	{
+		free(hash_table);
+		return NULL;
+	}
+
+	/* Initialize the locks */
+	if (pthread_mutex_init(&hash_table->reclaim_lock, NULL))
+	{
+		free(hash_table->lists);
+		free(hash_table);
+		return NULL;
+	}
+	for (i = 0; i < STRIPES; ++i)
+	{
+		if (pthread_mutex_init(&hash_table->stripes[i].lock, NULL))
+		{
+			/* Clean up previously created locks on failure */
+			while (0 < i)
+				pthread_mutex_destroy(&hash_table->stripes[--i].lock);
+			pthread_mutex_destroy(&hash_table->reclaim_lock);
+			free(hash_table->lists);
+			free(hash_table);
+			return NULL;
+		}
+	}
+
+	hash_table->cmp_func = cmp_func;
+	hash_table->hash_func = hash_func;
+
+	return hash_table;
+}
+
+/*===========================================================================*/
+
+void ConcurrentHashDestroy(concurrent_hash_table_t* hashTable)
+{
+	int i = 0;
+
+	if (NULL == hashTable)
+		return;
+
+	/* Free the entries, removed or not, and the locks */
+	for (i = 0; i < STRIPES; ++i)
+	{
+		FreeRetired(hashTable->stripes[i].retired);
+		pthread_mutex_destroy(&hashTable->stripes[i].lock);
+	}
+	FreeLists(hashTable->lists);
+	pthread_mutex_destroy(&hashTable->reclaim_lock);
+	free(hashTable);
+}
+
+/*===========================================================================*/
+
+int ConcurrentHashInsert(concurrent_hash_table_t* hashTable, void* data)
+{
+	conc_entry_t* entry = NULL;
+	conc_lists_t* lists = NULL;
+	stripe_t* stripe = NULL;
+	size_t index = 0;
+	size_t size = 0;
+	int grow = 0;
+
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(NULL != data);
+
+	entry = (conc_entry_t*) malloc(sizeof(conc_entry_t));
+	if (NULL == entry)
+		return 1; /* Failure */
+	entry->hash = hashTable->hash_func(data);
+	entry->data = data;
+	entry->retired = NULL;
+
+	stripe = StripeOf(hashTable, entry->hash);
+	pthread_mutex_lock(&stripe->lock);
+
+	/* Growth holds every stripe, so the lists can't change under this one */
+	lists = __atomic_load_n(&hashTable->lists, __ATOMIC_RELAXED);
+	index = ListIndex(lists, entry->hash);
+
+	/* Link the entry fully, then publish it at the head of its list */
+	entry->next = lists->heads[index];
+	__atomic_store_n(&lists->heads[index], entry, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&stripe->count, stripe->count + 1, __ATOMIC_RELAXED);
+	size = lists->size;
+	grow = stripe->count > (size >> STRIPE_BITS);
+
+	pthread_mutex_unlock(&stripe->lock);
+
+	/* Double once this range averages more than one element per list. The
+	element is in either way, so a failed growth leaves the table as is */
+	if (grow)
+		Grow(hashTable, size);
+
+	return 0; /* Success */
+}
+
+/*===========================================================================*/
+
+void* ConcurrentHashRemove(concurrent_hash_table_t* hashTable,
+                           const void* key)
+{
+	size_t hash = 0;
+	stripe_t* stripe = NULL;
+	conc_lists_t* lists = NULL;
+	conc_entry_t** link = NULL;
+	conc_entry_t* entry = NULL;
+	conc_entry_t* batch = NULL;
+	void* data = NULL;
+
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(NULL != key);
+
+	hash = hashTable->hash_func(key);
+	stripe = StripeOf(hashTable, hash);
+	pthread_mutex_lock(&stripe->lock);
+
+	/* Find the link to the entry to remove */
+	lists = __atomic_load_n(&hashTable->lists, __ATOMIC_RELAXED);
+	link = &lists->heads[ListIndex(lists, hash)];
+	while (NULL != (entry = *link) &&
+	       (hash != entry->hash || !hashTable->cmp_func(entry->data, key)))
+	{
+		link = &entry->next;
+	}
+
+	if (NULL != entry)
+	{
+		/* Unlink it; readers already on it still find their way on */
+		__atomic_store_n(link, entry->next, __ATOMIC_RELEASE);
+		__atomic_store_n(&stripe->count, stripe->count - 1, __ATOMIC_RELAXED);
+		data = entry->data;
+
+		/* Free it once no reader can be on it, a batch at a time */
+		entry->retired = stripe->retired;
+		stripe->retired = entry;
+		if (RETIRE_BATCH <= ++stripe->retired_count)
+		{
+			batch = stripe->retired;
+			stripe->retired = NULL;
+			stripe->retired_count = 0;
+		}
+	}
+
+	pthread_mutex_unlock(&stripe->lock);
+
+	if (NULL != batch)
+	{
+		WaitForReaders(hashTable);
+		FreeRetired(batch);
+	}
+
+	return data;
+}
+
+/*===========================================================================*/
+
+void* ConcurrentHashFind(const concurrent_hash_table_t* hashTable,
+                         const void* key)
+{
+	size_t hash = 0;
+	size_t* counter = NULL;
+	conc_lists_t* lists = NULL;
+	conc_entry_t* entry = NULL;
+	void* data = NULL;
+
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(NULL != key);
+
+	hash = hashTable->hash_func(key);
+
+	counter = EnterRead(hashTable);
+	lists = __atomic_load_n(&hashTable->lists, __ATOMIC_ACQUIRE);
+	entry = __atomic_load_n(&lists->heads[ListIndex(lists, hash)],
+	                        __ATOMIC_ACQUIRE);
+	while (NULL != entry)
+	{
+		if (hash == entry->hash && hashTable->cmp_func(entry->data, key))
+		{
+			data = entry->data;
+			break;
+		}
+		entry = __atomic_load_n(&entry->next, __ATOMIC_ACQUIRE);
+	}
+	ExitRead(counter);
+
+	return data;
+}
+
+/*===========================================================================*/
+
+size_t ConcurrentHashSize(const concurrent_hash_table_t* hashTable)
+{
+	size_t size = 0;
+	int i = 0;
+
+	/* Validate input parameter */
+	assert(NULL != hashTable);
+
+	for (i = 0; i < STRIPES; ++i)
+		size += __atomic_load_n(&hashTable->stripes[i].count, __ATOMIC_RELAXED);
+
+	return size;
+}
+
+/*===========================================================================*/
+
+int ConcurrentHashIsEmpty(const concurrent_hash_table_t* hashTable)
+{
+	/* Validate input parameter */
+	assert(NULL != hashTable);
+
+	return (0 == ConcurrentHashSize(hashTable)) ? 1 : 0;
+}
+
+/*===========================================================================*/
+
+int ConcurrentHashForeach(const concurrent_hash_table_t* hashTable,
+                          Action action, void* params)
+{
+	size_t* counter = NULL;
+	conc_lists_t* lists = NULL;
+	conc_entry_t* entry = NULL;
+	size_t i = 0;
+	int result = 0;
+
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(NULL != action);
+
+	counter = EnterRead(hashTable);
+	lists = __atomic_load_n(&hashTable->lists, __ATOMIC_ACQUIRE);
+	for (i = 0; i < lists->size && 0 == result; ++i)
+	{
+		entry = __atomic_load_n(&lists->heads[i], __ATOMIC_ACQUIRE);
+		while (NULL != entry && 0 == result)
+		{
+			result = action(entry->data, params);
+			entry = __atomic_load_n(&entry->next, __ATOMIC_ACQUIRE);
+		}
+	}
+	ExitRead(counter);
+
+	return result;
+}
+
+/*================================= ADVANCED =================================*/
+
+double ConcurrentHashLoad(const concurrent_hash_table_t* hashTable)
+{
+	size_t* counter = NULL;
+	size_t size = 0;
+
+	/* Validate input parameter */
+	assert(NULL != hashTable);
+
+	/* Old lists are freed after growth, so read the size as a reader */
+	counter = EnterRead(hashTable);
+	size = __atomic_load_n(&hashTable->lists, __ATOMIC_ACQUIRE)->size;
+	ExitRead(counter);
+
+	return (double) ConcurrentHashSize(hashTable) / (double) size;
+}
+
+/*===========================================================================*/
+
+void ConcurrentHashSynchronize(concurrent_hash_table_t* hashTable)
+{
+	conc_entry_t* batch = NULL;
+	conc_entry_t* last = NULL;
+	stripe_t* stripe = NULL;
+	int i = 0;
+
+	/* Validate input parameter */
+	assert(NULL != hashTable);
+
+	/* Take every stripe's removed entries */
+	for (i = 0; i < STRIPES; ++i)
+	{
+		stripe = &hashTable->stripes[i];
+		pthread_mutex_lock(&stripe->lock);
+		for (last = stripe->retired; NULL != last && NULL != last->retired;
+		     last = last->retired)
+			;
+		if (NULL != last)
+		{
+			last->retired = batch;
+			batch = stripe->retired;
+		}
+		stripe->retired = NULL;
+		stripe->retired_count = 0;
+		pthread_mutex_unlock(&stripe->lock);
+	}
+
+	WaitForReaders(hashTable);
+	FreeRetired(batch);
+}
+
+/*============================== HELPER FUNCS ==============================*/
+
+/* Empty lists of size, a power of 2 */
+static conc_lists_t* CreateLists(size_t size)
+{
+	conc_lists_t* lists = NULL;
+	unsigned shift = 64;
+	size_t i = 0;
+
+	lists = (conc_lists_t*) calloc(
+	    1, sizeof(conc_lists_t) + size * sizeof(conc_entry_t*));
+	if (NULL == lists)
+		return NULL;
+
+	for (i = size; 1 < i; i >>= 1)
+		--shift;
+	lists->size = size;
+	lists->shift = shift;
+
+	return lists;
+}
+
+/*===========================================================================*/
+
+static size_t ListIndex(const conc_lists_t* lists, size_t hash)
+{
+	return (size_t) (((uint64_t) hash * FIBONACCI_MULTIPLIER) >> lists->shift);
+}
+
+/*===========================================================================*/
+
+/* Stripe owning the lists hash can go to, now and after any growth */
+static stripe_t* StripeOf(concurrent_hash_table_t* hashTable, size_t hash)
+{
+	return &hashTable->stripes[((uint64_t) hash * FIBONACCI_MULTIPLIER) >>
+	                           (64 - STRIPE_BITS)];
+}
+
+/*===========================================================================*/
+
+/* Announce a reader; pass the result to ExitRead. Never blocks */
+static size_t* EnterRead(const concurrent_hash_table_t* hashTable)
+{
+	static unsigned next_stripe = 0;
+	static __thread unsigned stripe = 0; /* 0 - not assigned yet */
+	concurrent_hash_table_t* table = (concurrent_hash_table_t*) hashTable;
+	size_t* counter = NULL;
+	unsigned parity = 0;
+
+	if (0 == stripe)
+		stripe = __atomic_add_fetch(&next_stripe, 1, __ATOMIC_RELAXED);
+	parity = __atomic_load_n(&table->epoch, __ATOMIC_SEQ_CST) & 1;
+	counter = &table->readers[parity][stripe % READER_STRIPES].count;
+	__atomic_add_fetch(counter, 1, __ATOMIC_SEQ_CST);
+
+	return counter;
+}
+
+/*===========================================================================*/
+
+static void ExitRead(size_t* counter)
+{
+	__atomic_sub_fetch(counter, 1, __ATOMIC_RELEASE);
+}
+
+/*===========================================================================*/
+
+/* Return once no reader that started before the call is still reading. The
+epoch is flipped twice: a reader that read the parity just before one flip
+is caught by the wait on the other */
+static void WaitForReaders(concurrent_hash_table_t* hashTable)
+{
+	unsigned parity = 0;
+	int flip = 0;
+	int i = 0;
+
+	pthread_mutex_lock(&hashTable->reclaim_lock);
+	for (flip = 0; flip < 2; ++flip)
+	{
+		parity = __atomic_fetch_add(&hashTable->epoch, 1, __ATOMIC_SEQ_CST) & 1;
+		for (i = 0; i < READER_STRIPES; ++i)
+		{
+			while (__atomic_load_n(&hashTable->readers[parity][i].count,
+			                       __ATOMIC_SEQ_CST))
+				sched_yield();
+		}
+	}
+	pthread_mutex_unlock(&hashTable->reclaim_lock);
+}
+
+/*===========================================================================*/
+
+/* Double the lists, unless someone already grew them past seen_size.
+Readers may be walking the old entries, so they are copied into the new
+lists rather than relinked, and the old ones freed after the readers leave */
+static void Grow(concurrent_hash_table_t* hashTable, size_t seen_size)
+{
+	conc_lists_t* old_lists = NULL;
+	conc_lists_t* new_lists = NULL;
+	conc_entry_t* entry = NULL;
+	conc_entry_t* copy = NULL;
+	size_t index = 0;
+	size_t i = 0;
+	int s = 0;
+
+	/* Stop every writer, in stripe order */
+	for (s = 0; s < STRIPES; ++s)
+		pthread_mutex_lock(&hashTable->stripes[s].lock);
+
+	old_lists = hashTable->lists;
+	if (old_lists->size == seen_size)
+		new_lists = CreateLists(seen_size * 2);
+
+	for (i = 0; NULL != new_lists && i < old_lists->size; ++i)
+	{
+		for (entry = old_lists->heads[i]; NULL != entry; entry = entry->next)
+		{
+			copy = (conc_entry_t*) malloc(sizeof(conc_entry_t));
+			if (NULL == copy)
+			{
+				FreeLists(new_lists);
+				new_lists = NULL;
+				break;
+			}
+			*copy = *entry;
+			index = ListIndex(new_lists, copy->hash);
+			copy->next = new_lists->heads[index];
+			new_lists->heads[index] = copy;
+		}
+	}
+
+	if (NULL != new_lists)
+		__atomic_store_n(&hashTable->lists, new_lists, __ATOMIC_RELEASE);
+
+	for (s = STRIPES; 0 < s; --s)
+		pthread_mutex_unlock(&hashTable->stripes[s - 1].lock);
+
+	if (NULL != new_lists)
+	{
+		WaitForReaders(hashTable);
+		FreeLists(old_lists);
+	}
+}
+
+/*===========================================================================*/
+
+/* Free lists and every entry in them */
+static void FreeLists(conc_lists_t* lists)
+{
+	conc_entry_t* entry = NULL;
+	conc_entry_t* next_entry = NULL;
+	size_t i = 0;
+
+	for (i = 0; i < lists->size; ++i)
+	{
+		for (entry = lists->heads[i]; NULL != entry; entry = next_entry)
+		{
+			next_entry = entry->next;
+			free(entry);
+		}
+	}
+	free(lists);
+}
+
+/*===========================================================================*/
+
+/* Free a chain of removed entries, linked through retired */
+static void FreeRetired(conc_entry_t* entry)
+{
+	conc_entry_t* next_entry = NULL;
+
+	for (; NULL != entry; entry = next_entry)
+	{
+		next_entry = entry->retired;
+		free(entry);
+	}
+}
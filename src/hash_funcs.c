@@ -0,0 +1,173 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+#include "../include/hash_funcs.h"
+
+#include <string.h> /* memcpy, strlen */
+#include <assert.h> /* assert */
+
+/* Odd constants with balanced bits, from wyhash */
+#define SECRET0 (0xa0761d6478bd642fULL)
+#define SECRET1 (0xe7037ed1a0b428dbULL)
+#define SECRET2 (0x8ebc6af09c88c6e3ULL)
+#define SECRET3 (0x589965cc75374cc3ULL)
+
+/*======================= DECLARATION OF HELPER FUNCS =======================*/
+
+static void Multiply(uint64_t* a, uint64_t* b);
+static uint64_t Mix(uint64_t a, uint64_t b);
+static uint64_t Read64(const unsigned char* p);
+static uint64_t Read32(const unsigned char* p);
+
+/*================================ API FUNCS ================================*/
+
+size_t HashU64(uint64_t value)
+{
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ULL;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebULL;
+	value ^= value >> 31;
+
+	return (size_t) value;
+}
+
+/*===========================================================================*/
+
+size_t HashInt(const void* key)
+{
+	/* Validate input parameter */
+	assert(NULL != key);
+
+	return HashU64((uint64_t) (unsigned) *(const int*) key);
+}
+
+/*===========================================================================*/
+
+size_t HashPtr(const void* key)
+{
+	return HashU64((uint64_t) (uintptr_t) key);
+}
+
+/*===========================================================================*/
+
+size_t HashBytes(const void* data, size_t len, uint64_t seed)
+{
+	const unsigned char* p = (const unsigned char*) data;
+	size_t left = len;
+	uint64_t a = 0;
+	uint64_t b = 0;
+	uint64_t seed1 = 0;
+	uint64_t seed2 = 0;
+
+	/* Validate input parameters */
+	assert(NULL != data || 0 == len);
+
+	seed ^= Mix(seed ^ SECRET0, SECRET1);
+
+	if (16 >= len)
+	{
+		/* Short keys: two overlapping reads cover every byte */
+		if (4 <= len)
+		{
+			a = (Read32(p) << 32) | Read32(p + ((len >> 3) << 2));
+			b = (Read32(p + len - 4) << 32) |
+			    Read32(p + len - 4 - ((len >> 3) << 2));
+		}
+		else if (0 < len)
+		{
+			a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) |
+			    p[len - 1];
+		}
+	}
+	else
+	{
+		/* Three independent lanes keep the multiplier busy */
+		if (48 < left)
+		{
+			seed1 = seed;
+			seed2 = seed;
+			do
+			{
+				seed = Mix(Read64(p) ^ SECRET1, Read64(p + 8) ^ seed);
+				seed1 = Mix(Read64(p + 16) ^ SECRET2, Read64(p + 24) ^ seed1);
+				seed2 = Mix(Read64(p + 32) ^ SECRET3, Read64(p + 40) ^ seed2);
+				p += 48;
+				left -= 48;
+			} while (48 < left);
+			seed ^= seed1 ^ seed2;
+		}
+		while (16 < left)
+		{
+			seed = Mix(Read64(p) ^ SECRET1, Read64(p + 8) ^ seed);
+			p += 16;
+			left -= 16;
+		}
+
+		/* Last 16 bytes, overlapping what was already mixed */
+		a = Read64(p + left - 16);
+		b = Read64(p + left - 8);
+	}
+
+	a ^= SECRET1;
+	b ^= seed;
+	Multiply(&a, &b);
+
+	return (size_t) Mix(a ^ SECRET0 ^ (uint64_t) len, b ^ SECRET1);
+}
+
+/*===========================================================================*/
+
+size_t HashStr(const void* key)
+{
+	/* Validate input parameter */
+	assert(NULL != key);
+
+	return HashBytes(key, strlen((const char*) key), 0);
+}
+
+/*============================== HELPER FUNCS ==============================*/
+
+/* Full 128 bit product of a and b: low half into a, high half into b */
+static void Multiply(uint64_t* a, uint64_t* b)
+{
+	uint64_t ha = *a >> 32;
+	uint64_t hb = *b >> 32;
+	uint64_t la = (uint32_t) *a;
+	uint64_t lb = (uint32_t) *b;
+	uint64_t rh = ha * hb;
+	uint64_t rm0 = ha * lb;
+	uint64_t rm1 = hb * la;
+	uint64_t rl = la * lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t carry = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+
+	carry += lo < t;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+	*a = lo;
+}
+
+/* Both halves of a * b folded together */
+static uint64_t Mix(uint64_t a, uint64_t b)
+{
+	Multiply(&a, &b);
+	return a ^ b;
+}
+
+static uint64_t Read64(const unsigned char* p)
+{
+	uint64_t value = 0;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static uint64_t Read32(const unsigned char* p)
+{
+	uint32_t value = 0;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
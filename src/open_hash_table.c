@@ -0,0 +1,354 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+#include "../include/open_hash_table.h"
+
+#include <stdlib.h> /* malloc, calloc, free */
+#include <stdint.h> /* uint64_t */
+#include <limits.h> /* UCHAR_MAX */
+#include <assert.h> /* assert */
+
+/* Slots of a table created with capacity 0, and the fewest it can have */
+#define DEFAULT_CAPACITY (16)
+#define MIN_CAPACITY (8)
+
+/* Grow once more than 7/8 of the slots are taken */
+#define MAX_LOAD_NUM (7)
+#define MAX_LOAD_DEN (8)
+
+/* A distance byte this big means "look at the hash instead" */
+#define DIST_SATURATED (UCHAR_MAX)
+
+/* 2^64 / golden ratio: spreads weak hashes (e.g. identity) over the bits
+that pick the home slot */
+#define FIBONACCI_MULTIPLIER (0x9E3779B97F4A7C15ULL)
+
+/* One slot. The hash sits next to its element, so a hit reads the
+distance bytes and then this one 16 byte record */
+typedef struct open_slot
+{
+	size_t hash; /* hash_func(data) */
+	void* data;  /* User data */
+} open_slot_t;
+
+/* Hash table structure definition */
+struct open_hash_table
+{
+	open_slot_t* slots;    /* Elements with their hashes, one per slot */
+	unsigned char* dists;  /* Probe distance + 1 per slot, 0 if empty */
+	size_t capacity;       /* Number of slots, a power of 2 */
+	unsigned shift;        /* 64 - log2(capacity) */
+	size_t num_elements;   /* Total number of elements stored */
+	cmp_func_t cmp_func;   /* Comparison function pointer */
+	hash_func_t hash_func; /* Hash function pointer */
+};
+
+/*======================= DECLARATION OF HELPER FUNCS =======================*/
+
+static size_t Home(const open_hash_table_t* hashTable, size_t hash);
+static size_t Dist(const open_hash_table_t* hashTable, size_t index);
+static void SetDist(open_hash_table_t* hashTable, size_t index, size_t dist);
+static void Place(open_hash_table_t* hashTable, open_slot_t slot);
+static size_t Locate(const open_hash_table_t* hashTable, const void* key);
+static int Resize(open_hash_table_t* hashTable, size_t capacity);
+
+/*================================ API FUNCS ================================*/
+
+open_hash_table_t* OpenHashCreate(cmp_func_t cmp_func, hash_func_t hash_func,
+                                  size_t capacity)
+{
+	open_hash_table_t* hash_table = NULL;
+
+	/* Validate input parameters */
+	assert(NULL != cmp_func);
+	assert(NULL != hash_func);
+
+	hash_table = (open_hash_table_t*) malloc(sizeof(open_hash_table_t));
+	if (NULL == hash_table)
+		return NULL;
+
+	/* Initialize hash table fields */
+	hash_table->slots = NULL;
+	hash_table->dists = NULL;
+	hash_table->capacity = 0;
+	hash_table->shift = 0;
+	hash_table->num_elements = 0;
+	hash_table->cmp_func = cmp_func;
+	hash_table->hash_func = hash_func;
+
+	/* Allocate the slot array */
+	if (Resize(hash_table, capacity ? capacity : DEFAULT_CAPACITY))
+	{
+		free(hash_table);
+		return NULL;
+	}
+
+	return hash_table;
+}
+
+/*===========================================================================*/
+
+void OpenHashDestroy(open_hash_table_t* hashTable)
+{
+	if (NULL == hashTable)
+		return;
+
+	free(hashTable->slots);
+	free(hashTable->dists);
+	free(hashTable);
+}
+
+/*===========================================================================*/
+
+int OpenHashInsert(open_hash_table_t* hashTable, void* data)
+{
+	open_slot_t slot;
+
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(NULL != data);
+
+	/* Make room first, so placing can't fail half way */
+	if ((hashTable->num_elements + 1) * MAX_LOAD_DEN >
+	        hashTable->capacity * MAX_LOAD_NUM &&
+	    Resize(hashTable, hashTable->capacity * 2))
+	{
+		return 1; /* Failure */
+	}
+
+	slot.hash = hashTable->hash_func(data);
+	slot.data = data;
+	Place(hashTable, slot);
+	++hashTable->num_elements;
+
+	return 0; /* Success */
+}
+
+/*===========================================================================*/
+
+void OpenHashRemove(open_hash_table_t* hashTable, const void* key)
+{
+	size_t mask = 0;
+	size_t index = 0;
+	size_t next = 0;
+
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(NULL != key);
+
+	index = Locate(hashTable, key);
+	if (index == hashTable->capacity)
+		return;
+
+	/* Backward shift: pull each following displaced element one slot
+	closer to its home, so no tombstone is left behind */
+	mask = hashTable->capacity - 1;
+	next = (index + 1) & mask;
+	while (hashTable->dists[next] > 1)
+	{
+		hashTable->slots[index] = hashTable->slots[next];
+		SetDist(hashTable, index, Dist(hashTable, next) - 1);
+		index = next;
+		next = (next + 1) & mask;
+	}
+	hashTable->slots[index].data = NULL;
+	hashTable->dists[index] = 0;
+	--hashTable->num_elements;
+}
+
+/*===========================================================================*/
+
+void* OpenHashFind(const open_hash_table_t* hashTable, const void* key)
+{
+	size_t index = 0;
+
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(NULL != key);
+
+	index = Locate(hashTable, key);
+	if (index == hashTable->capacity)
+		return NULL;
+	return hashTable->slots[index].data;
+}
+
+/*===========================================================================*/
+
+size_t OpenHashSize(const open_hash_table_t* hashTable)
+{
+	/* Validate input parameter */
+	assert(NULL != hashTable);
+
+	return hashTable->num_elements;
+}
+
+/*===========================================================================*/
+
+int OpenHashIsEmpty(const open_hash_table_t* hashTable)
+{
+	/* Validate input parameter */
+	assert(NULL != hashTable);
+
+	return (0 == hashTable->num_elements) ? 1 : 0;
+}
+
+/*===========================================================================*/
+
+int OpenHashForeach(const open_hash_table_t* hashTable, Action action,
+                    void* params)
+{
+	size_t i = 0;
+	int result = 0;
+
+	/* Validate input parameters */
+	assert(NULL != hashTable);
+	assert(NULL != action);
+
+	/* Visit every taken slot */
+	for (i = 0; i < hashTable->capacity && 0 == result; ++i)
+	{
+		if (hashTable->dists[i])
+			result = action(hashTable->slots[i].data, params);
+	}
+
+	return result;
+}
+
+/*================================= ADVANCED =================================*/
+
+double OpenHashLoad(const open_hash_table_t* hashTable)
+{
+	/* Validate input parameter */
+	assert(NULL != hashTable);
+
+	return (double) hashTable->num_elements / (double) hashTable->capacity;
+}
+
+/*============================== HELPER FUNCS ==============================*/
+
+/* Slot an element with this hash would take in an empty table */
+static size_t Home(const open_hash_table_t* hashTable, size_t hash)
+{
+	return (size_t) (((uint64_t) hash * FIBONACCI_MULTIPLIER) >>
+	                 hashTable->shift);
+}
+
+/* Probe distance + 1 of a taken slot. Distances that don't fit the byte
+are worked out from the element's home */
+static size_t Dist(const open_hash_table_t* hashTable, size_t index)
+{
+	size_t dist = hashTable->dists[index];
+
+	if (DIST_SATURATED != dist)
+		return dist;
+	return ((index - Home(hashTable, hashTable->slots[index].hash)) &
+	        (hashTable->capacity - 1)) + 1;
+}
+
+static void SetDist(open_hash_table_t* hashTable, size_t index, size_t dist)
+{
+	hashTable->dists[index] =
+	    (unsigned char) (dist < DIST_SATURATED ? dist : DIST_SATURATED);
+}
+
+/* Robin Hood insertion: an element that has come further from home than
+the one in a slot takes that slot, and the evicted one walks on */
+static void Place(open_hash_table_t* hashTable, open_slot_t slot)
+{
+	size_t mask = hashTable->capacity - 1;
+	size_t index = Home(hashTable, slot.hash);
+	size_t dist = 1;
+	size_t taken = 0;
+	open_slot_t evicted;
+
+	while (hashTable->dists[index])
+	{
+		/* A saturated byte only matters once dist gets that far too */
+		taken = hashTable->dists[index];
+		if (DIST_SATURATED == taken && dist >= DIST_SATURATED)
+			taken = Dist(hashTable, index);
+		if (taken < dist)
+		{
+			evicted = hashTable->slots[index];
+			hashTable->slots[index] = slot;
+			SetDist(hashTable, index, dist);
+			slot = evicted;
+			dist = taken;
+		}
+		index = (index + 1) & mask;
+		++dist;
+	}
+	hashTable->slots[index] = slot;
+	SetDist(hashTable, index, dist);
+}
+
+/* Slot holding key, capacity if none. Elements are ordered by distance
+along a probe, so the search ends at the first one closer to its home than
+key would be. cmp_func only runs on elements with the same hash */
+static size_t Locate(const open_hash_table_t* hashTable, const void* key)
+{
+	size_t hash = hashTable->hash_func(key);
+	size_t mask = hashTable->capacity - 1;
+	size_t index = Home(hashTable, hash);
+	size_t dist = 1;
+	size_t taken = 0;
+
+	while (0 != (taken = hashTable->dists[index]))
+	{
+		if (DIST_SATURATED == taken && dist >= DIST_SATURATED)
+			taken = Dist(hashTable, index);
+		if (taken < dist)
+			break;
+		if (hash == hashTable->slots[index].hash &&
+		    hashTable->cmp_func(hashTable->slots[index].data, key))
+			return index;
+		index = (index + 1) & mask;
+		++dist;
+	}
+	return hashTable->capacity;
+}
+
+/* Move every element into a new slot array of at least capacity slots,
+placed by their stored hashes */
+static int Resize(open_hash_table_t* hashTable, size_t capacity)
+{
+	open_slot_t* old_slots = hashTable->slots;
+	unsigned char* old_dists = hashTable->dists;
+	size_t old_capacity = hashTable->capacity;
+	size_t new_capacity = MIN_CAPACITY;
+	unsigned shift = 64 - 3; /* log2(MIN_CAPACITY) */
+	size_t i = 0;
+
+	while (new_capacity < capacity)
+	{
+		new_capacity *= 2;
+		--shift;
+	}
+
+	hashTable->slots =
+	    (open_slot_t*) malloc(sizeof(open_slot_t) * new_capacity);
+	hashTable->dists = (unsigned char*) calloc(new_capacity, 1);
+	if (NULL == hashTable->slots || NULL == hashTable->dists)
+	{
+		free(hashTable->slots);
+		free(hashTable->dists);
+		hashTable->slots = old_slots;
+		hashTable->dists = old_dists;
+		return 1;
+	}
+	hashTable->capacity = new_capacity;
+	hashTable->shift = shift;
+
+	for (i = 0; i < old_capacity; ++i)
+	{
+		if (old_dists[i])
+			Place(hashTable, old_slots[i]);
+	}
+
+	free(old_slots);
+	free(old_dists);
+	return 0;
+}
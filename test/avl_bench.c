@@ -0,0 +1,182 @@
+/*****************************************
+ * date: Tue Jun 17 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: John Doe               *
+ *****************************************/
+
+/*
+    Read scaling of AVLCreateConcurrent against a plain tree behind a global
+    mutex, with one writer churning the tree throughout.
+
+    gcc -O2 -Iinclude src/avl.c test/avl_bench.c -pthread -o bin/release/avl_bench.out
+    ./bin/release/avl_bench.out [max_readers]
+*/
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* malloc, free, atoi */
+#include <time.h>   /* clock_gettime */
+#include <unistd.h> /* sysconf */
+#include <sched.h>  /* sched_yield */
+#include <pthread.h>
+
+#include "../include/avl.h"
+
+#define BENCH_KEYS (1 << 20)
+#define BENCH_SECONDS (0.5)
+
+typedef struct bench_s
+{
+	avl_t* tree;
+	pthread_mutex_t* lock; /* NULL for the concurrent tree */
+	int* keys;
+	int stop;
+} bench_t;
+
+typedef struct reader_s
+{
+	bench_t* bench;
+	unsigned seed;
+	size_t lookups;
+	pthread_t thread;
+} reader_t;
+
+static int IntCompare(const void* data, const void* tree_data)
+{
+	int a = *(int*) data;
+	int b = *(int*) tree_data;
+	return (a > b) - (a < b);
+}
+
+static double Now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void* Reader(void* arg)
+{
+	reader_t* reader = (reader_t*) arg;
+	bench_t* bench = reader->bench;
+	size_t lookups = 0;
+	int i = 0;
+
+	while (!__atomic_load_n(&bench->stop, __ATOMIC_RELAXED))
+	{
+		for (i = 0; i < 256; i++)
+		{
+			int* key = &bench->keys[rand_r(&reader->seed) % BENCH_KEYS];
+			if (bench->lock)
+				pthread_mutex_lock(bench->lock);
+			AVLFind(bench->tree, key);
+			if (bench->lock)
+				pthread_mutex_unlock(bench->lock);
+		}
+		lookups += 256;
+	}
+	reader->lookups = lookups;
+	return NULL;
+}
+
+/* the odd keys are removed and put back while the readers run */
+static void* Writer(void* arg)
+{
+	bench_t* bench = (bench_t*) arg;
+	unsigned seed = 7;
+	int* key = NULL;
+
+	while (!__atomic_load_n(&bench->stop, __ATOMIC_RELAXED))
+	{
+		key = &bench->keys[(rand_r(&seed) % (BENCH_KEYS / 2)) * 2 + 1];
+		if (bench->lock)
+			pthread_mutex_lock(bench->lock);
+		AVLRemove(bench->tree, key);
+		AVLInsert(bench->tree, key);
+		if (bench->lock)
+			pthread_mutex_unlock(bench->lock);
+	}
+	return NULL;
+}
+
+/* returns millions of lookups per second over all readers */
+static double Run(bench_t* bench, int nreaders)
+{
+	reader_t* readers = malloc(sizeof(reader_t) * nreaders);
+	pthread_t writer;
+	size_t total = 0;
+	double start = 0.0;
+	double elapsed = 0.0;
+	int i = 0;
+
+	bench->stop = 0;
+	for (i = 0; i < nreaders; i++)
+	{
+		readers[i].bench = bench;
+		readers[i].seed = (unsigned) i + 1;
+		pthread_create(&readers[i].thread, NULL, Reader, &readers[i]);
+	}
+	pthread_create(&writer, NULL, Writer, bench);
+
+	start = Now();
+	while (Now() - start < BENCH_SECONDS)
+		sched_yield();
+	__atomic_store_n(&bench->stop, 1, __ATOMIC_RELAXED);
+
+	for (i = 0; i < nreaders; i++)
+	{
+		pthread_join(readers[i].thread, NULL);
+		total += readers[i].lookups;
+	}
+	pthread_join(writer, NULL);
+	elapsed = Now() - start;
+
+	free(readers);
+	return (double) total / elapsed / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+	int max_readers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	int* keys = malloc(sizeof(int) * BENCH_KEYS);
+	pthread_mutex_t lock;
+	bench_t locked;
+	bench_t concurrent;
+	int i = 0;
+	int n = 0;
+
+	if (argc > 1)
+		max_readers = atoi(argv[1]);
+	if (max_readers < 1)
+		max_readers = 1;
+
+	pthread_mutex_init(&lock, NULL);
+	locked.tree = AVLCreateWithPool(IntCompare, 0);
+	locked.lock = &lock;
+	locked.keys = keys;
+	concurrent.tree = AVLCreateConcurrent(IntCompare);
+	concurrent.lock = NULL;
+	concurrent.keys = keys;
+
+	for (i = 0; i < BENCH_KEYS; i++)
+	{
+		keys[i] = i;
+		AVLInsert(locked.tree, &keys[i]);
+		AVLInsert(concurrent.tree, &keys[i]);
+	}
+
+	printf("%d keys, 1 writer, %.1fs per run (Mlookups/s)\n", BENCH_KEYS,
+	       BENCH_SECONDS);
+	printf("%8s %14s %14s\n", "readers", "global mutex", "concurrent");
+	for (n = 1; n <= max_readers; n *= 2)
+	{
+		printf("%8d %14.2f %14.2f\n", n, Run(&locked, n), Run(&concurrent, n));
+		if (n < max_readers && n * 2 > max_readers)
+			n = max_readers / 2;
+	}
+
+	AVLDestroy(locked.tree);
+	AVLDestroy(concurrent.tree);
+	pthread_mutex_destroy(&lock);
+	free(keys);
+	return 0;
+}
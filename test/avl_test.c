@@ -8,6 +8,7 @@
 #include <stdlib.h> /* malloc */
 #include <string.h> /* strcmp */
 #include <assert.h> /* assert */
+#include <pthread.h> /* pthread_create, pthread_join */
 
 #include "../include/avl.h"
 
@@ -56,6 +57,41 @@ int StringCompare(const void* data, const void* tree_data)
 	return strcmp((const char*) data, (const char*) tree_data);
 }
 
+static int compare_calls = 0;
+
+int CountingIntCompare(const void* data, const void* tree_data)
+{
+	++compare_calls;
+	return IntCompare(data, tree_data);
+}
+
+uint32_t IntPrefix(const void* data)
+{
+	return (uint32_t) *(const int*) data ^ 0x80000000u;
+}
+
+/* Fixed-size record for save/load, keyed by id */
+typedef struct record_s
+{
+	int id;
+	int value;
+} record_t;
+
+int RecordCompare(const void* data, const void* tree_data)
+{
+	return IntCompare(&((const record_t*) data)->id,
+	                  &((const record_t*) tree_data)->id);
+}
+
+/* Per-task part for the parallel reduce test */
+typedef struct span_s
+{
+	int first;
+	int last;
+	long sum;
+	int seen;
+} span_t;
+
 /* Operation functions for ForEach testing */
 int PrintIntOp(void* tree_data)
 {
@@ -78,6 +114,47 @@ int CountOp(void* tree_data, void* arg)
 	return 0;
 }
 
+int AtomicSumOp(void* tree_data, void* arg)
+{
+	__atomic_fetch_add((long*) arg, *(int*) tree_data, __ATOMIC_RELAXED);
+	return 0;
+}
+
+int FailAtOp(void* tree_data, void* arg)
+{
+	return *(int*) tree_data == *(int*) arg ? 7 : 0;
+}
+
+int SpanOp(void* tree_data, void* arg)
+{
+	span_t* span = (span_t*) arg;
+	int value = *(int*) tree_data;
+	if (!span->seen)
+		span->first = value;
+	else if (value <= span->last)
+		return 1; /* out of order inside a task */
+	span->last = value;
+	span->sum += value;
+	span->seen = 1;
+	return 0;
+}
+
+/* fold spans left to right; sum goes negative if they arrive out of order */
+void SpanReduce(void* arg, void* part)
+{
+	span_t* total = (span_t*) arg;
+	span_t* span = (span_t*) part;
+	if (!span->seen)
+		return;
+	if (total->seen && span->first <= total->last)
+		total->sum = -1000000000L;
+	if (!total->seen)
+		total->first = span->first;
+	total->last = span->last;
+	total->sum += span->sum;
+	total->seen = 1;
+}
+
 int FailingOp(void* tree_data, void* arg)
 {
 	(void) tree_data;
@@ -85,6 +162,72 @@ int FailingOp(void* tree_data, void* arg)
 	return -1; /* Always fails */
 }
 
+/*
+    height of the subtree whose in-order members are depths[lo..hi), rooted
+    at the one member at depth. Clears *ok if the depths don't form a tree
+    or some node's sides differ in height by more than 1
+*/
+size_t ShapeHeight(const size_t* depths, size_t lo, size_t hi, size_t depth,
+                   int* ok)
+{
+	size_t i = 0;
+	size_t root = hi;
+	size_t left = 0;
+	size_t right = 0;
+
+	if (lo == hi)
+		return 0;
+	for (i = lo; i < hi; i++)
+	{
+		if (depths[i] == depth && root == hi)
+			root = i;
+		else if (depths[i] <= depth)
+			*ok = 0;
+	}
+	if (root == hi)
+	{
+		*ok = 0;
+		return 0;
+	}
+	left = ShapeHeight(depths, lo, root, depth + 1, ok);
+	right = ShapeHeight(depths, root + 1, hi, depth + 1, ok);
+	*ok &= left <= right + 1 && right <= left + 1;
+	return 1 + (left > right ? left : right);
+}
+
+/*
+    checks every node is balanced and holds the right subtree size. The
+    shape comes from the iterator's path depth at each member; Select and
+    Rank read the sizes, so both must agree with in-order position
+*/
+int CheckShape(const avl_t* tree)
+{
+	int ok = 1;
+	size_t i = 0;
+	size_t count = AVLCount(tree);
+	size_t* depths = (size_t*) malloc((count + 1) * sizeof(size_t));
+	avl_iter_t iter;
+
+	if (!depths)
+		return 0;
+	for (AVLIterBegin(tree, &iter); !AVLIterIsEnd(&iter); AVLIterNext(&iter))
+	{
+		ok &= i < count;
+		if (!ok)
+			break;
+		depths[i] = iter.depth;
+		ok &= AVLSelect(tree, i) == AVLIterGetData(&iter);
+		ok &= AVLRank(tree, AVLIterGetData(&iter)) == i;
+		++i;
+	}
+	ok &= i == count && AVLSelect(tree, count) == NULL;
+	if (ok)
+		ok &= ShapeHeight(depths, 0, count, 1, &ok) == AVLHeight(tree);
+
+	free(depths);
+	return ok;
+}
+
 /* Test functions */
 
 int TestAVLCreate()
@@ -455,6 +598,1141 @@ int TestComplexScenarios()
 	TEST_END();
 }
 
+int TestRandomInsertRemove()
+{
+	int i = 0;
+	int ok = 1;
+	size_t count = 0;
+	size_t max_height = 0;
+	avl_t* tree = NULL;
+	static int keys[1000];
+	static char present[1000];
+
+	TEST_START();
+
+	tree = AVLCreate(IntCompare);
+	srand(1234);
+	for (i = 0; i < 1000; i++)
+	{
+		keys[i] = i;
+	}
+
+	/* Random interleaving of inserts and removes against a reference set */
+	for (i = 0; i < 20000; i++)
+	{
+		int k = rand() % 1000;
+		if (present[k])
+		{
+			AVLRemove(tree, &keys[k]);
+			present[k] = 0;
+			count--;
+		}
+		else
+		{
+			ok &= AVLInsert(tree, &keys[k]) == 0;
+			present[k] = 1;
+			count++;
+		}
+	}
+	TEST_ASSERT(ok, "All inserts of absent keys should succeed");
+	TEST_ASSERT(AVLCount(tree) == count,
+	            "Count should match the reference set");
+
+	for (i = 0; i < 1000; i++)
+	{
+		ok &= (AVLFind(tree, &keys[i]) != NULL) == present[i];
+	}
+	TEST_ASSERT(ok, "Find should agree with the reference set");
+
+	/* 1.44 * log2(1000) ~= 14.4 */
+	max_height = AVLHeight(tree);
+	TEST_ASSERT(max_height <= 15, "Height should stay within the AVL bound");
+
+	TEST_ASSERT(AVLInsert(tree, &keys[0]) != 0 || !present[0],
+	            "Inserting a duplicate should fail");
+
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLPool()
+{
+	int i = 0;
+	int ok = 1;
+	avl_t* tree = NULL;
+	static int values[200];
+
+	TEST_START();
+
+	tree = AVLCreateWithPool(IntCompare, 16);
+	TEST_ASSERT(tree != NULL, "AVLCreateWithPool should succeed");
+	TEST_ASSERT(AVLCreateWithPool(NULL, 16) == NULL,
+	            "AVLCreateWithPool with NULL compare function should fail");
+
+	/* Spans several chunks */
+	for (i = 0; i < 200; i++)
+	{
+		values[i] = i;
+		ok &= AVLInsert(tree, &values[i]) == 0;
+	}
+	TEST_ASSERT(ok, "Pooled inserts should succeed");
+
+	/* Freed nodes go back to the free list and are reused */
+	for (i = 0; i < 200; i += 2)
+	{
+		AVLRemove(tree, &values[i]);
+	}
+	for (i = 0; i < 200; i += 2)
+	{
+		ok &= AVLInsert(tree, &values[i]) == 0;
+	}
+	TEST_ASSERT(ok, "Reinserting into recycled nodes should succeed");
+	TEST_ASSERT(AVLCount(tree) == 200, "Pooled tree count should be correct");
+
+	for (i = 0; i < 200; i++)
+	{
+		ok &= AVLFind(tree, &values[i]) == &values[i];
+	}
+	TEST_ASSERT(ok, "All pooled elements should be findable");
+
+	AVLDestroy(tree);
+
+	/* Default chunk size */
+	tree = AVLCreateWithPool(IntCompare, 0);
+	TEST_ASSERT(AVLInsert(tree, &values[0]) == 0,
+	            "Insert with default chunk size should succeed");
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLSelectRank()
+{
+	int i = 0;
+	int ok = 1;
+	int missing = 0;
+	avl_t* tree = NULL;
+	static int values[100];
+
+	TEST_START();
+
+	tree = AVLCreate(IntCompare);
+	TEST_ASSERT(AVLSelect(tree, 0) == NULL, "Select on empty tree is NULL");
+
+	/* Insert even numbers 0..198 in a scrambled order */
+	for (i = 0; i < 100; i++)
+	{
+		values[i] = ((i * 37) % 100) * 2;
+		AVLInsert(tree, &values[i]);
+	}
+
+	for (i = 0; i < 100; i++)
+	{
+		int* found = AVLSelect(tree, (size_t) i);
+		ok &= found && *found == i * 2;
+	}
+	TEST_ASSERT(ok, "Select should return members in sorted order");
+	TEST_ASSERT(AVLSelect(tree, 100) == NULL,
+	            "Select past the end should return NULL");
+
+	for (i = 0; i < 100; i++)
+	{
+		ok &= AVLRank(tree, &values[i]) == (size_t) (values[i] / 2);
+	}
+	TEST_ASSERT(ok, "Rank of a member should be its sorted position");
+
+	missing = 51;
+	TEST_ASSERT(AVLRank(tree, &missing) == 26,
+	            "Rank of a non-member counts smaller members");
+
+	/* Sizes must survive removals and rotations */
+	for (i = 0; i < 100; i += 3)
+	{
+		AVLRemove(tree, &values[i]);
+	}
+	for (i = 0; i + 1 < (int) AVLCount(tree); i++)
+	{
+		ok &= *(int*) AVLSelect(tree, (size_t) i) <
+		      *(int*) AVLSelect(tree, (size_t) i + 1);
+		ok &= AVLRank(tree, AVLSelect(tree, (size_t) i)) == (size_t) i;
+	}
+	TEST_ASSERT(ok, "Select and Rank should agree after removals");
+
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLRange()
+{
+	int i = 0;
+	int lo = 0;
+	int hi = 0;
+	int sum = 0;
+	int count = 0;
+	int result = 0;
+	avl_t* tree = NULL;
+	int values[] = {10, 20, 30, 40, 50, 60, 70, 80, 90};
+
+	TEST_START();
+
+	tree = AVLCreate(IntCompare);
+	for (i = 0; i < 9; i++)
+	{
+		AVLInsert(tree, &values[i]);
+	}
+
+	lo = 25;
+	hi = 60;
+	result = AVLForEachRange(tree, &lo, &hi, SumOp, &sum);
+	TEST_ASSERT(result == 0, "AVLForEachRange should return 0 on success");
+	TEST_ASSERT(sum == 30 + 40 + 50 + 60,
+	            "Range should include members within inclusive bounds");
+
+	lo = 61;
+	hi = 69;
+	AVLForEachRange(tree, &lo, &hi, CountOp, &count);
+	TEST_ASSERT(count == 0, "Range between members should be empty");
+
+	lo = 0;
+	hi = 100;
+	count = 0;
+	AVLForEachRange(tree, &lo, &hi, CountOp, &count);
+	TEST_ASSERT(count == 9, "Range covering the tree should visit all");
+
+	result = AVLForEachRange(tree, &lo, &hi, FailingOp, NULL);
+	TEST_ASSERT(result != 0, "AVLForEachRange should stop on failure");
+
+	lo = 40;
+	TEST_ASSERT(*(int*) AVLLowerBound(tree, &lo) == 40,
+	            "LowerBound of a member is the member");
+	TEST_ASSERT(*(int*) AVLUpperBound(tree, &lo) == 50,
+	            "UpperBound of a member is its successor");
+	lo = 41;
+	TEST_ASSERT(*(int*) AVLLowerBound(tree, &lo) == 50,
+	            "LowerBound of a non-member is the next member");
+	lo = 5;
+	TEST_ASSERT(*(int*) AVLLowerBound(tree, &lo) == 10,
+	            "LowerBound below the minimum is the minimum");
+	lo = 90;
+	TEST_ASSERT(AVLUpperBound(tree, &lo) == NULL,
+	            "UpperBound of the maximum is NULL");
+	TEST_ASSERT(AVLLowerBound(NULL, &lo) == NULL,
+	            "LowerBound with NULL tree should return NULL");
+
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLIterator()
+{
+	int i = 0;
+	int ok = 1;
+	int key = 0;
+	avl_t* tree = NULL;
+	avl_iter_t iter;
+	static int values[50];
+
+	TEST_START();
+
+	tree = AVLCreate(IntCompare);
+	AVLIterBegin(tree, &iter);
+	TEST_ASSERT(AVLIterIsEnd(&iter), "Begin of empty tree should be end");
+
+	for (i = 0; i < 50; i++)
+	{
+		values[i] = ((i * 13) % 50) * 2;
+		AVLInsert(tree, &values[i]);
+	}
+
+	/* Forward walk */
+	i = 0;
+	for (AVLIterBegin(tree, &iter); !AVLIterIsEnd(&iter); AVLIterNext(&iter))
+	{
+		ok &= *(int*) AVLIterGetData(&iter) == i * 2;
+		i++;
+	}
+	TEST_ASSERT(ok && i == 50, "Forward iteration should be in order");
+	TEST_ASSERT(AVLIterGetData(&iter) == NULL, "Data at end should be NULL");
+
+	/* Backward walk from end */
+	AVLIterEnd(tree, &iter);
+	for (i = 49; i >= 0; i--)
+	{
+		AVLIterPrev(&iter);
+		ok &= !AVLIterIsEnd(&iter) && *(int*) AVLIterGetData(&iter) == i * 2;
+	}
+	TEST_ASSERT(ok, "Backward iteration should be in reverse order");
+	AVLIterPrev(&iter);
+	TEST_ASSERT(AVLIterIsEnd(&iter), "Previous of the minimum should be end");
+
+	/* Seek and resume */
+	key = 31;
+	AVLIterSeek(tree, &key, &iter);
+	TEST_ASSERT(*(int*) AVLIterGetData(&iter) == 32,
+	            "Seek should land on the lower bound");
+	AVLIterNext(&iter);
+	TEST_ASSERT(*(int*) AVLIterGetData(&iter) == 34,
+	            "Next after seek should continue in order");
+	AVLIterPrev(&iter);
+	AVLIterPrev(&iter);
+	TEST_ASSERT(*(int*) AVLIterGetData(&iter) == 30,
+	            "Prev after seek should go back in order");
+	key = 99;
+	AVLIterSeek(tree, &key, &iter);
+	TEST_ASSERT(AVLIterIsEnd(&iter), "Seek past the maximum should be end");
+
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLBuildFromSorted()
+{
+	int i = 0;
+	int ok = 1;
+	int extra = 1000;
+	avl_t* tree = NULL;
+	static int values[1000];
+	static void* items[1000];
+
+	TEST_START();
+
+	for (i = 0; i < 1000; i++)
+	{
+		values[i] = i;
+		items[i] = &values[i];
+	}
+
+	tree = AVLBuildFromSorted(IntCompare, items, 1000);
+	TEST_ASSERT(tree != NULL, "AVLBuildFromSorted should succeed");
+	TEST_ASSERT(AVLCount(tree) == 1000, "Built tree count should be n");
+	TEST_ASSERT(AVLHeight(tree) == 10, "Built tree should be perfectly balanced");
+	for (i = 0; i < 1000; i++)
+	{
+		ok &= AVLFind(tree, &values[i]) == &values[i];
+		ok &= AVLSelect(tree, (size_t) i) == &values[i];
+	}
+	TEST_ASSERT(ok, "All built members should be findable and ordered");
+
+	/* The built tree must behave like any other */
+	TEST_ASSERT(AVLInsert(tree, &extra) == 0, "Insert after build should work");
+	for (i = 0; i < 1000; i += 2)
+	{
+		AVLRemove(tree, &values[i]);
+	}
+	TEST_ASSERT(AVLCount(tree) == 501, "Remove after build should work");
+	AVLDestroy(tree);
+
+	tree = AVLBuildFromSorted(IntCompare, items, 0);
+	TEST_ASSERT(tree != NULL && AVLIsEmpty(tree),
+	            "Building from no items gives an empty tree");
+	AVLDestroy(tree);
+
+	items[5] = &values[3];
+	TEST_ASSERT(AVLBuildFromSorted(IntCompare, items, 1000) == NULL,
+	            "Unsorted items should be rejected");
+	TEST_ASSERT(AVLBuildFromSorted(NULL, items, 1000) == NULL,
+	            "NULL compare function should be rejected");
+
+	TEST_END();
+}
+
+int TestAVLFreeze()
+{
+	int i = 0;
+	int n = 0;
+	int ok = 1;
+	int key = 0;
+	avl_t* tree = NULL;
+	avl_frozen_t* frozen = NULL;
+	static int values[300];
+
+	TEST_START();
+
+	/* Every size up to 300 exercises full and partial last levels */
+	tree = AVLCreate(IntCompare);
+	for (n = 0; n <= 300; n++)
+	{
+		frozen = AVLFreeze(tree);
+		ok &= frozen != NULL && AVLFrozenCount(frozen) == (size_t) n;
+		for (i = 0; i < n; i++)
+		{
+			key = i * 2;
+			ok &= AVLFrozenFind(frozen, &key) == &values[i];
+			key = i * 2 - 1;
+			ok &= AVLFrozenFind(frozen, &key) == NULL;
+			ok &= AVLFrozenLowerBound(frozen, &key) == &values[i];
+		}
+		key = n * 2;
+		ok &= AVLFrozenLowerBound(frozen, &key) == NULL;
+		AVLFrozenDestroy(frozen);
+
+		if (n < 300)
+		{
+			values[n] = n * 2;
+			AVLInsert(tree, &values[n]);
+		}
+	}
+	TEST_ASSERT(ok, "Frozen snapshot should match the tree for every size");
+
+	/* Snapshot is independent of later tree changes */
+	frozen = AVLFreeze(tree);
+	AVLDestroy(tree);
+	key = 100;
+	TEST_ASSERT(AVLFrozenFind(frozen, &key) == &values[50],
+	            "Snapshot should outlive its tree");
+	AVLFrozenDestroy(frozen);
+
+	TEST_ASSERT(AVLFreeze(NULL) == NULL, "AVLFreeze with NULL tree fails");
+	TEST_ASSERT(AVLFrozenFind(NULL, &key) == NULL,
+	            "AVLFrozenFind with NULL snapshot returns NULL");
+	AVLFrozenDestroy(NULL);
+
+	TEST_END();
+}
+
+int TestAVLFindMany()
+{
+	int i = 0;
+	int ok = 1;
+	avl_t* tree = NULL;
+	static int values[500];
+	static int probes[100];
+	static const void* keys[100];
+	static void* out[100];
+
+	TEST_START();
+
+	tree = AVLCreate(IntCompare);
+	for (i = 0; i < 100; i++)
+	{
+		probes[i] = i * 7;
+		keys[i] = &probes[i];
+	}
+	TEST_ASSERT(AVLFindMany(tree, keys, 100, out) == 0,
+	            "FindMany on empty tree finds nothing");
+	TEST_ASSERT(out[0] == NULL && out[99] == NULL,
+	            "FindMany on empty tree clears results");
+
+	/* Even numbers below 1000 */
+	for (i = 0; i < 500; i++)
+	{
+		values[i] = i * 2;
+		AVLInsert(tree, &values[i]);
+	}
+
+	/* Batch size not a multiple of the group */
+	TEST_ASSERT(AVLFindMany(tree, keys, 100, out) == 50,
+	            "FindMany should count the members found");
+	for (i = 0; i < 100; i++)
+	{
+		ok &= out[i] == AVLFind(tree, keys[i]);
+	}
+	TEST_ASSERT(ok, "FindMany should agree with AVLFind for each key");
+
+	TEST_ASSERT(AVLFindMany(NULL, keys, 100, out) == 0,
+	            "FindMany with NULL tree finds nothing");
+
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+#define CONCURRENT_KEYS 2000
+#define CONCURRENT_READERS 4
+
+static int concurrent_keys[CONCURRENT_KEYS];
+static int concurrent_done = 0;
+
+/* Even keys stay in the tree for the whole run; odd keys come and go */
+void* ConcurrentReader(void* arg)
+{
+	avl_t* tree = (avl_t*) arg;
+	size_t misses = 0;
+	int i = 0;
+
+	while (!__atomic_load_n(&concurrent_done, __ATOMIC_ACQUIRE))
+	{
+		for (i = 0; i < CONCURRENT_KEYS; i += 2)
+		{
+			misses += AVLFind(tree, &concurrent_keys[i]) != &concurrent_keys[i];
+		}
+		AVLFind(tree, &concurrent_keys[1]);
+		misses += AVLCount(tree) < CONCURRENT_KEYS / 2;
+	}
+	return (void*) misses;
+}
+
+int TestAVLConcurrent()
+{
+	int i = 0;
+	int round = 0;
+	int ok = 1;
+	void* misses = NULL;
+	avl_t* tree = NULL;
+	pthread_t readers[CONCURRENT_READERS];
+
+	TEST_START();
+
+	tree = AVLCreateConcurrent(IntCompare);
+	TEST_ASSERT(tree != NULL, "AVLCreateConcurrent should succeed");
+	for (i = 0; i < CONCURRENT_KEYS; i++)
+	{
+		concurrent_keys[i] = i;
+		if (i % 2 == 0)
+			AVLInsert(tree, &concurrent_keys[i]);
+	}
+
+	concurrent_done = 0;
+	for (i = 0; i < CONCURRENT_READERS; i++)
+	{
+		pthread_create(&readers[i], NULL, ConcurrentReader, tree);
+	}
+
+	/* Writer churns the odd keys, causing rotations all over the tree */
+	for (round = 0; round < 10; round++)
+	{
+		for (i = 1; i < CONCURRENT_KEYS; i += 2)
+		{
+			ok &= AVLInsert(tree, &concurrent_keys[i]) == 0;
+		}
+		for (i = 1; i < CONCURRENT_KEYS; i += 2)
+		{
+			AVLRemove(tree, &concurrent_keys[i]);
+		}
+	}
+	__atomic_store_n(&concurrent_done, 1, __ATOMIC_RELEASE);
+
+	for (i = 0; i < CONCURRENT_READERS; i++)
+	{
+		pthread_join(readers[i], &misses);
+		ok &= misses == NULL;
+	}
+	TEST_ASSERT(ok, "Readers should always see the stable keys");
+
+	AVLSynchronize(tree);
+	TEST_ASSERT(AVLCount(tree) == CONCURRENT_KEYS / 2,
+	            "Count should be back to the stable keys");
+	for (i = 0; i < CONCURRENT_KEYS; i++)
+	{
+		ok &= (AVLFind(tree, &concurrent_keys[i]) != NULL) == (i % 2 == 0);
+	}
+	TEST_ASSERT(ok, "Tree should hold exactly the stable keys");
+	TEST_ASSERT(AVLInsert(tree, &concurrent_keys[0]) != 0,
+	            "Concurrent insert of a duplicate should fail");
+	TEST_ASSERT(AVLHeight(tree) <= 16, "Concurrent tree should stay balanced");
+
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLSnapshot()
+{
+	int i = 0;
+	int ok = 1;
+	int sum = 0;
+	int round = 0;
+	avl_t* tree = NULL;
+	avl_t* before = NULL;
+	avl_t* after = NULL;
+	static int values[200];
+
+	TEST_START();
+
+	TEST_ASSERT(AVLSnapshot(NULL) == NULL, "Snapshot of NULL should fail");
+	tree = AVLCreate(IntCompare);
+	TEST_ASSERT(AVLSnapshot(tree) == NULL,
+	            "Snapshot of a plain tree should fail");
+	AVLDestroy(tree);
+
+	tree = AVLCreatePersistent(IntCompare);
+	TEST_ASSERT(tree != NULL, "AVLCreatePersistent should succeed");
+	for (i = 0; i < 100; i++)
+	{
+		values[i] = i;
+		values[i + 100] = i + 100;
+		AVLInsert(tree, &values[i]);
+	}
+
+	before = AVLSnapshot(tree);
+	TEST_ASSERT(before != NULL, "AVLSnapshot should succeed");
+
+	/* Rework the live tree: drop evens, add 100..199 */
+	for (i = 0; i < 100; i += 2)
+	{
+		AVLRemove(tree, &values[i]);
+	}
+	for (i = 100; i < 200; i++)
+	{
+		AVLInsert(tree, &values[i]);
+	}
+	after = AVLSnapshot(tree);
+
+	TEST_ASSERT(AVLCount(before) == 100, "Old snapshot keeps its count");
+	for (i = 0; i < 200; i++)
+	{
+		ok &= (AVLFind(before, &values[i]) != NULL) == (i < 100);
+		ok &= (AVLFind(after, &values[i]) != NULL) == (i >= 100 || i % 2);
+	}
+	TEST_ASSERT(ok, "Snapshots should not see later updates");
+	AVLForEach(before, SumOp, &sum);
+	TEST_ASSERT(sum == 99 * 100 / 2, "Snapshot ForEach sees the old members");
+	TEST_ASSERT(AVLSelect(before, 0) == &values[0],
+	            "Snapshot Select sees the old order");
+	TEST_ASSERT(AVLInsert(before, &values[150]) != 0,
+	            "Insert into a snapshot should fail");
+	AVLRemove(before, &values[1]);
+	TEST_ASSERT(AVLCount(before) == 100, "Remove from a snapshot is a no-op");
+
+	/* Heavy churn with snapshots alive, then after they are released */
+	for (round = 0; round < 20; round++)
+	{
+		if (round == 10)
+			AVLDestroy(before);
+		for (i = 100; i < 200; i++)
+		{
+			AVLRemove(tree, &values[i]);
+		}
+		for (i = 100; i < 200; i++)
+		{
+			AVLInsert(tree, &values[i]);
+		}
+	}
+	for (i = 0; i < 200; i++)
+	{
+		ok &= (AVLFind(after, &values[i]) != NULL) == (i >= 100 || i % 2);
+		ok &= (AVLFind(tree, &values[i]) != NULL) == (i >= 100 || i % 2);
+	}
+	TEST_ASSERT(ok, "Snapshot and tree should survive churn and reclaiming");
+
+	AVLDestroy(after);
+	AVLSynchronize(tree);
+	TEST_ASSERT(AVLCount(tree) == 150, "Live tree count should be correct");
+
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLSetOps()
+{
+	int i = 0;
+	int ok = 1;
+	int round = 0;
+	int shape = 1;
+	avl_t* a = NULL;
+	avl_t* b = NULL;
+	avl_t* u = NULL;
+	avl_t* x = NULL;
+	avl_t* d = NULL;
+	avl_t* right = NULL;
+	static int values[1000];
+	static char in_a[1000];
+	static char in_b[1000];
+
+	TEST_START();
+
+	for (i = 0; i < 1000; i++)
+	{
+		values[i] = i;
+	}
+
+	/* Random sets of very different sizes against a reference */
+	for (round = 0; round < 8; round++)
+	{
+		a = AVLCreate(IntCompare);
+		b = AVLCreateWithPool(IntCompare, 64);
+		u = AVLCreate(IntCompare);
+		x = AVLCreateWithPool(IntCompare, 0);
+		d = AVLCreate(IntCompare);
+		for (i = 0; i < 1000; i++)
+		{
+			in_a[i] = rand() % 2;
+			in_b[i] = rand() % (1 + round * 3) == 0;
+			if (in_a[i])
+			{
+				AVLInsert(a, &values[i]);
+				AVLInsert(u, &values[i]);
+				AVLInsert(x, &values[i]);
+				AVLInsert(d, &values[i]);
+			}
+			if (in_b[i])
+				AVLInsert(b, &values[i]);
+		}
+		ok &= AVLUnion(u, b) == 0;
+		ok &= AVLIntersect(x, b) == 0;
+		ok &= AVLDifference(d, b) == 0;
+		for (i = 0; i < 1000; i++)
+		{
+			ok &= (AVLFind(u, &values[i]) != NULL) == (in_a[i] || in_b[i]);
+			ok &= (AVLFind(x, &values[i]) != NULL) == (in_a[i] && in_b[i]);
+			ok &= (AVLFind(d, &values[i]) != NULL) == (in_a[i] && !in_b[i]);
+			ok &= (AVLFind(b, &values[i]) != NULL) == in_b[i];
+		}
+		ok &= AVLCount(u) + AVLCount(x) == AVLCount(a) + AVLCount(b);
+		ok &= AVLCount(x) + AVLCount(d) == AVLCount(a);
+		ok &= AVLHeight(u) <= 15 && AVLHeight(x) <= 15 && AVLHeight(d) <= 15;
+		shape &= CheckShape(u) && CheckShape(x) && CheckShape(d);
+		shape &= CheckShape(b);
+		AVLDestroy(a);
+		AVLDestroy(b);
+		AVLDestroy(u);
+		AVLDestroy(x);
+		AVLDestroy(d);
+	}
+	TEST_ASSERT(ok, "Union, intersection and difference match the reference");
+	TEST_ASSERT(shape, "Set op results should be balanced with right sizes");
+
+	/* Split and join back */
+	a = AVLCreate(IntCompare);
+	for (i = 0; i < 1000; i += 2)
+	{
+		AVLInsert(a, &values[i]);
+	}
+	right = AVLSplit(a, &values[500]);
+	TEST_ASSERT(right != NULL, "AVLSplit should succeed");
+	TEST_ASSERT(AVLCount(a) == 251 && AVLCount(right) == 249,
+	            "Split point should stay on the left");
+	TEST_ASSERT(AVLSelect(right, 0) == &values[502] &&
+	                AVLSelect(a, 250) == &values[500],
+	            "Split halves should hold the right ranges");
+	TEST_ASSERT(CheckShape(a) && CheckShape(right),
+	            "Split halves should be balanced with right sizes");
+	TEST_ASSERT(AVLJoin(right, a) != 0, "Join of misordered trees should fail");
+	TEST_ASSERT(AVLJoin(a, right) == 0, "AVLJoin should succeed");
+	TEST_ASSERT(AVLCount(a) == 500 && AVLIsEmpty(right),
+	            "Join should move every member");
+	for (i = 0; i < 1000; i++)
+	{
+		ok &= (AVLFind(a, &values[i]) != NULL) == (i % 2 == 0);
+	}
+	TEST_ASSERT(ok && AVLHeight(a) <= 12, "Joined tree should be whole");
+	TEST_ASSERT(CheckShape(a), "Joined tree should be balanced with right sizes");
+	AVLDestroy(right);
+	AVLDestroy(a);
+
+	/* Pooled trees hand their nodes over on join */
+	a = AVLCreateWithPool(IntCompare, 16);
+	b = AVLCreateWithPool(IntCompare, 16);
+	for (i = 0; i < 100; i++)
+	{
+		AVLInsert(i < 50 ? a : b, &values[i]);
+	}
+	AVLRemove(b, &values[60]);
+	TEST_ASSERT(AVLSplit(a, &values[10]) == NULL,
+	            "Split of a pooled tree should fail");
+	TEST_ASSERT(AVLJoin(a, b) == 0, "Join of pooled trees should succeed");
+	TEST_ASSERT(CheckShape(a),
+	            "Pooled join should be balanced with right sizes");
+	AVLDestroy(b);
+	for (i = 100; i < 200; i++)
+	{
+		AVLInsert(a, &values[i]);
+	}
+	TEST_ASSERT(AVLCount(a) == 199, "Pooled join should keep every member");
+
+	b = AVLCreatePersistent(IntCompare);
+	TEST_ASSERT(AVLUnion(b, a) != 0, "Set ops on a persistent tree should fail");
+	TEST_ASSERT(AVLUnion(a, b) == 0 && AVLCount(a) == 199 && CheckShape(a),
+	            "Persistent tree can be a source");
+	AVLDestroy(b);
+	AVLDestroy(a);
+	TEST_END();
+}
+
+int TestAVLPrefix()
+{
+	int i = 0;
+	int ok = 1;
+	int plain_calls = 0;
+	int in_range = 0;
+	int lo = -100;
+	int hi = 100;
+	avl_t* tree = NULL;
+	avl_t* plain = NULL;
+	avl_t* snapshot = NULL;
+	static int values[1000];
+	char* words[] = {"applesauce", "apple", "", "app", "b", "apples", "ab",
+	                 "apply", "\xff\xff", "applf"};
+	int num_words = sizeof(words) / sizeof(words[0]);
+
+	TEST_START();
+
+	TEST_ASSERT(AVLStringPrefix("abcdef") == 0x61626364u &&
+	                AVLStringPrefix("ab") == 0x61620000u,
+	            "String prefix should be the first bytes big-endian");
+
+	/* Signed ints: the prefix decides everything but the match itself */
+	tree = AVLCreate(CountingIntCompare);
+	plain = AVLCreate(CountingIntCompare);
+	TEST_ASSERT(AVLSetPrefix(tree, IntPrefix) == 0, "AVLSetPrefix should succeed");
+	for (i = 0; i < 1000; i++)
+	{
+		values[i] = (i * 7919) % 1000 - 500;
+		AVLInsert(tree, &values[i]);
+		AVLInsert(plain, &values[i]);
+	}
+	TEST_ASSERT(AVLSetPrefix(tree, NULL) != 0,
+	            "AVLSetPrefix on a non-empty tree should fail");
+	compare_calls = 0;
+	for (i = 0; i < 1000; i++)
+	{
+		AVLFind(plain, &values[i]);
+	}
+	plain_calls = compare_calls;
+	compare_calls = 0;
+	for (i = 0; i < 1000; i++)
+	{
+		ok &= AVLFind(tree, &values[i]) == &values[i];
+		ok &= AVLRank(tree, &values[i]) == (size_t) (values[i] + 500);
+	}
+	TEST_ASSERT(ok, "Prefixed tree should find and rank every member");
+	TEST_ASSERT(compare_calls == 2000 && plain_calls > 5000,
+	            "Prefix should leave one compare call per lookup");
+	compare_calls = 0;
+	AVLForEachRange(tree, &lo, &hi, CountOp, &in_range);
+	TEST_ASSERT(in_range == 201 && compare_calls == 2,
+	            "Range walks should only call the sorting method on ties");
+	for (i = 0; i < 1000; i += 2)
+	{
+		AVLRemove(tree, &values[i]);
+	}
+	for (i = 0; i < 1000; i++)
+	{
+		ok &= (AVLFind(tree, &values[i]) != NULL) == (i % 2 == 1);
+	}
+	TEST_ASSERT(ok && AVLCount(tree) == 500, "Prefixed removal should work");
+	TEST_ASSERT(*(int*) AVLSelect(tree, 0) == -499 &&
+	                *(int*) AVLLowerBound(tree, &values[0]) == -499,
+	            "Prefixed tree should keep signed order");
+	AVLDestroy(plain);
+	AVLDestroy(tree);
+
+	/* Strings sharing long prefixes fall back to the sorting method */
+	tree = AVLCreatePersistent(StringCompare);
+	AVLSetPrefix(tree, AVLStringPrefix);
+	for (i = 0; i < num_words; i++)
+	{
+		ok &= AVLInsert(tree, words[i]) == 0;
+	}
+	snapshot = AVLSnapshot(tree);
+	AVLRemove(tree, "apple");
+	for (i = 0; i < num_words; i++)
+	{
+		ok &= AVLFind(snapshot, words[i]) == words[i];
+		ok &= (AVLFind(tree, words[i]) != NULL) == (strcmp(words[i], "apple") != 0);
+	}
+	TEST_ASSERT(ok, "Prefixed strings should be found, in snapshots too");
+	for (i = 1; i < num_words; i++)
+	{
+		ok &= strcmp(AVLSelect(snapshot, i - 1), AVLSelect(snapshot, i)) < 0;
+	}
+	TEST_ASSERT(ok, "Prefixed strings should keep strcmp order");
+	TEST_ASSERT(AVLSetPrefix(snapshot, NULL) != 0,
+	            "AVLSetPrefix on a snapshot should fail");
+	AVLDestroy(snapshot);
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLMultiset()
+{
+	int i = 0;
+	int ok = 1;
+	int sum = 0;
+	int count = 0;
+	avl_t* tree = NULL;
+	void* const* values = NULL;
+	static int keys[300];
+
+	TEST_START();
+
+	tree = AVLCreate(IntCompare);
+	AVLInsert(tree, &keys[0]);
+	TEST_ASSERT(AVLSetMultiset(tree) != 0,
+	            "AVLSetMultiset on a non-empty tree should fail");
+	TEST_ASSERT(AVLFindAll(tree, &keys[0], &values) == 1 &&
+	                values[0] == &keys[0],
+	            "FindAll on a plain tree should return the single member");
+	AVLDestroy(tree);
+
+	/* 300 values over 30 keys, key i % 30 */
+	tree = AVLCreateWithPool(IntCompare, 8);
+	TEST_ASSERT(AVLSetMultiset(tree) == 0, "AVLSetMultiset should succeed");
+	for (i = 0; i < 300; i++)
+	{
+		keys[i] = i % 30;
+		ok &= AVLInsert(tree, &keys[i]) == 0;
+	}
+	TEST_ASSERT(ok, "Inserting equal keys should succeed");
+	TEST_ASSERT(AVLCount(tree) == 30, "Count should be distinct keys");
+	for (i = 0; i < 30; i++)
+	{
+		ok &= AVLFindAll(tree, &keys[i], &values) == 10;
+		ok &= values[0] == &keys[i] && values[9] == &keys[270 + i];
+		ok &= AVLFind(tree, &keys[i]) == &keys[i];
+	}
+	TEST_ASSERT(ok, "FindAll should return every value in insertion order");
+	AVLForEach(tree, CountOp, &count);
+	TEST_ASSERT(count == 300, "ForEach should visit every value");
+
+	/* Drop single values, then whole keys */
+	TEST_ASSERT(AVLRemoveValue(tree, &keys[5]) == 0,
+	            "AVLRemoveValue should succeed");
+	TEST_ASSERT(AVLRemoveValue(tree, &keys[5]) != 0,
+	            "AVLRemoveValue of a missing value should fail");
+	TEST_ASSERT(AVLFindAll(tree, &keys[35], &values) == 9 &&
+	                AVLFind(tree, &keys[35]) == &keys[35],
+	            "Next value should become the key's first");
+	for (i = 7; i < 300; i += 30)
+	{
+		ok &= AVLRemoveValue(tree, &keys[i]) == 0;
+	}
+	TEST_ASSERT(ok && AVLFindAll(tree, &keys[7], &values) == 0 &&
+	                AVLCount(tree) == 29,
+	            "Removing the last value should remove the key");
+	for (i = 0; i < 30; i += 2)
+	{
+		AVLRemove(tree, &keys[i]);
+	}
+	for (i = 0; i < 30; i++)
+	{
+		ok &= (AVLFind(tree, &keys[i]) != NULL) == (i % 2 == 1 && i != 7);
+	}
+	TEST_ASSERT(ok && AVLCount(tree) == 14, "AVLRemove should drop whole keys");
+	AVLForEach(tree, SumOp, &sum);
+	TEST_ASSERT(sum == (225 - 7) * 10 - 5, "Remaining values should be intact");
+
+	/* Removals that move a successor's group up */
+	for (i = 0; i < 30; i += 2)
+	{
+		AVLInsert(tree, &keys[i]);
+		AVLInsert(tree, &keys[i + 30]);
+	}
+	for (i = 1; i < 30; i += 4)
+	{
+		AVLRemove(tree, &keys[i]);
+	}
+	for (i = 0; i < 30; i++)
+	{
+		size_t n = AVLFindAll(tree, &keys[i], &values);
+		ok &= n == (i % 2 == 0 ? 2 : (i % 4 == 1 || i == 7) ? 0 : 10);
+	}
+	TEST_ASSERT(ok, "Groups should follow their keys through rebalancing");
+
+	TEST_ASSERT(AVLUnion(tree, tree) != 0, "Set ops on a multiset should fail");
+	AVLDestroy(tree);
+
+	tree = AVLCreatePersistent(IntCompare);
+	TEST_ASSERT(AVLSetMultiset(tree) != 0,
+	            "AVLSetMultiset on a persistent tree should fail");
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLSaveLoad()
+{
+	int i = 0;
+	int ok = 1;
+	avl_t* tree = NULL;
+	avl_frozen_t* loaded = NULL;
+	record_t* found = NULL;
+	record_t probe = {0, 0};
+	FILE* file = NULL;
+	static char head[64 + sizeof(record_t)];
+	static record_t records[1000];
+	const char* path = "avl_test_save.bin";
+
+	TEST_START();
+
+	tree = AVLCreate(RecordCompare);
+	for (i = 0; i < 1000; i++)
+	{
+		records[i].id = i * 2;
+		records[i].value = -i;
+		AVLInsert(tree, &records[i]);
+	}
+	TEST_ASSERT(AVLSave(tree, path, sizeof(record_t)) == 0,
+	            "AVLSave should succeed");
+	AVLDestroy(tree);
+
+	loaded = AVLLoad(path, RecordCompare);
+	TEST_ASSERT(loaded != NULL, "AVLLoad should succeed");
+	TEST_ASSERT(AVLFrozenCount(loaded) == 1000, "Loaded count should match");
+	for (i = 0; i < 1998; i++)
+	{
+		probe.id = i;
+		found = AVLFrozenFind(loaded, &probe);
+		ok &= (found != NULL) == (i % 2 == 0);
+		ok &= !found || (found->id == i && found->value == -i / 2);
+		found = AVLFrozenLowerBound(loaded, &probe);
+		ok &= found && found->id == i + (i % 2);
+		ok &= found != &records[(i + 1) / 2];
+	}
+	TEST_ASSERT(ok, "Loaded records should be found by value");
+	probe.id = 1999;
+	TEST_ASSERT(AVLFrozenLowerBound(loaded, &probe) == NULL,
+	            "Lower bound past the end should be NULL");
+	AVLFrozenDestroy(loaded);
+
+	/* Empty tree, then a truncated file */
+	tree = AVLCreate(RecordCompare);
+	TEST_ASSERT(AVLSave(tree, path, sizeof(record_t)) == 0,
+	            "Saving an empty tree should succeed");
+	loaded = AVLLoad(path, RecordCompare);
+	TEST_ASSERT(loaded && AVLFrozenCount(loaded) == 0 &&
+	                !AVLFrozenFind(loaded, &probe),
+	            "Loaded empty tree should be empty");
+	AVLFrozenDestroy(loaded);
+	AVLInsert(tree, &records[0]);
+	AVLInsert(tree, &records[1]);
+	AVLSave(tree, path, sizeof(record_t));
+	AVLDestroy(tree);
+	/* keep the header and the first of two records */
+	file = fopen(path, "rb");
+	TEST_ASSERT(file && fread(head, sizeof(head), 1, file) == 1,
+	            "Test file should read back");
+	fclose(file);
+	file = fopen(path, "wb");
+	TEST_ASSERT(file && fwrite(head, sizeof(head), 1, file) == 1,
+	            "Test file should be rewritten");
+	fclose(file);
+	TEST_ASSERT(AVLLoad(path, RecordCompare) == NULL,
+	            "AVLLoad of a truncated file should fail");
+	TEST_ASSERT(AVLLoad("avl_test_missing.bin", RecordCompare) == NULL,
+	            "AVLLoad of a missing file should fail");
+
+	remove(path);
+	TEST_END();
+}
+
+int TestAVLStats()
+{
+	int i = 0;
+	size_t d = 0;
+	size_t lookups = 0;
+	avl_t* tree = NULL;
+	int in_range = 0;
+	avl_t* right = NULL;
+	avl_t* built = NULL;
+	avl_stats_t stats;
+	static int values[1000];
+	static void* items[1000];
+	static int above = 1000;
+
+	TEST_START();
+
+	tree = AVLCreate(IntCompare);
+	for (i = 0; i < 1000; i++)
+	{
+		values[i] = i;
+		AVLInsert(tree, &values[i]);
+	}
+	if (AVLGetStats(tree, &stats) != 0)
+	{
+		/* built without AVL_STATS */
+		TEST_ASSERT(stats.comparisons == 0 && stats.allocations == 0,
+		            "Stats should read as zero when compiled out");
+		AVLDestroy(tree);
+		TEST_END();
+	}
+
+	TEST_ASSERT(stats.allocations == 1000, "Every insert should allocate");
+	TEST_ASSERT(stats.single_rotations > 0 && stats.double_rotations == 0,
+	            "Ascending inserts should only rotate singly");
+	TEST_ASSERT(stats.comparisons > 1000, "Descents should compare");
+
+	AVLResetStats(tree);
+	for (i = 0; i < 1000; i++)
+	{
+		AVLFind(tree, &values[i]);
+	}
+	AVLGetStats(tree, &stats);
+	for (d = 0; d <= AVLHeight(tree); d++)
+	{
+		lookups += stats.find_depth[d];
+	}
+	TEST_ASSERT(lookups == 1000 && stats.find_depth[1] == 1,
+	            "Depth histogram should count every lookup within the height");
+	TEST_ASSERT(stats.comparisons > 1000 && stats.allocations == 0,
+	            "Lookups should compare but not allocate");
+
+	/* Range walks compare like any other descent */
+	AVLResetStats(tree);
+	AVLForEachRange(tree, &values[10], &values[20], CountOp, &in_range);
+	AVLGetStats(tree, &stats);
+	TEST_ASSERT(in_range == 11 && stats.comparisons > 0,
+	            "Range walks should be counted");
+
+	/* Bulk loading carves n nodes and checks n - 1 pairs */
+	for (i = 0; i < 1000; i++)
+	{
+		items[i] = &values[i];
+	}
+	built = AVLBuildFromSorted(IntCompare, items, 1000);
+	AVLGetStats(built, &stats);
+	TEST_ASSERT(stats.allocations == 1000 && stats.comparisons == 999,
+	            "Bulk loading should count its nodes and comparisons");
+	AVLDestroy(built);
+
+	/* AVLJoin checks the trees don't overlap with one comparison */
+	right = AVLCreate(IntCompare);
+	AVLInsert(right, &above);
+	AVLResetStats(tree);
+	TEST_ASSERT(AVLJoin(tree, right) == 0, "AVLJoin should succeed");
+	AVLGetStats(tree, &stats);
+	TEST_ASSERT(stats.comparisons == 1,
+	            "The overlap check of AVLJoin should be counted");
+
+	AVLDestroy(right);
+	AVLDestroy(tree);
+	TEST_END();
+}
+
+int TestAVLParallel()
+{
+	int i = 0;
+	int fail_at = 0;
+	long sum = 0;
+	size_t threads = 0;
+	avl_t* tree = NULL;
+	span_t total;
+	static int values[100000];
+
+	TEST_START();
+
+	tree = AVLCreateWithPool(IntCompare, 0);
+	TEST_ASSERT(AVLParallelForEach(tree, AtomicSumOp, &sum, 4) == 0 && sum == 0,
+	            "Parallel ForEach on an empty tree should do nothing");
+	for (i = 0; i < 100000; i++)
+	{
+		values[i] = i;
+		AVLInsert(tree, &values[i]);
+	}
+
+	for (threads = 0; threads <= 8; threads += 4)
+	{
+		sum = 0;
+		TEST_ASSERT(AVLParallelForEach(tree, AtomicSumOp, &sum, threads) == 0,
+		            "AVLParallelForEach should succeed");
+		TEST_ASSERT(sum == 99999L * 100000 / 2,
+		            "Parallel ForEach should visit every member once");
+
+		memset(&total, 0, sizeof(total));
+		TEST_ASSERT(AVLParallelReduce(tree, SpanOp, sizeof(span_t), SpanReduce,
+		                              &total, threads) == 0,
+		            "AVLParallelReduce should succeed");
+		TEST_ASSERT(total.first == 0 && total.last == 99999 &&
+		                total.sum == 99999L * 100000 / 2,
+		            "Parts should be reduced in tree order");
+	}
+
+	fail_at = 54321;
+	TEST_ASSERT(AVLParallelForEach(tree, FailAtOp, &fail_at, 3) == 7,
+	            "Parallel ForEach should report a failing op");
+	TEST_ASSERT(AVLParallelReduce(tree, SpanOp, 0, SpanReduce, &total, 2) != 0,
+	            "Parallel reduce needs a part size");
+
+	AVLDestroy(tree);
+	TEST_END();
+}
+
 /* Main test runner */
 int main()
 {
@@ -471,6 +1749,22 @@ int main()
 	TestAVLForEach();
 	TestStringTree();
 	TestComplexScenarios();
+	TestRandomInsertRemove();
+	TestAVLPool();
+	TestAVLSelectRank();
+	TestAVLRange();
+	TestAVLIterator();
+	TestAVLBuildFromSorted();
+	TestAVLFreeze();
+	TestAVLFindMany();
+	TestAVLConcurrent();
+	TestAVLSnapshot();
+	TestAVLSetOps();
+	TestAVLPrefix();
+	TestAVLMultiset();
+	TestAVLSaveLoad();
+	TestAVLStats();
+	TestAVLParallel();
 
 	/* Print results */
 	printf("=== Test Results ===\n");
@@ -0,0 +1,205 @@
+/*****************************************
+ * date: Tue Jun 17 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: John Doe               *
+ *****************************************/
+
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* rand */
+#include <string.h> /* strcmp */
+
+#include "../include/avl_typed.h"
+
+/* Test counter and macros */
+static int test_count = 0;
+static int test_passed = 0;
+
+#define TEST_START()                                                           \
+	do                                                                         \
+	{                                                                          \
+		printf("Running test %d\n", ++test_count);                             \
+	} while (0)
+
+#define TEST_ASSERT(condition, message)                                        \
+	do                                                                         \
+	{                                                                          \
+		if (condition)                                                         \
+		{                                                                      \
+			printf("  ✓ %s\n", message);                                       \
+		}                                                                      \
+		else                                                                   \
+		{                                                                      \
+			printf("  ✗ %s - FAILED\n", message);                              \
+			return 0;                                                          \
+		}                                                                      \
+	} while (0)
+
+#define TEST_END()                                                             \
+	do                                                                         \
+	{                                                                          \
+		printf("  Test %d passed!\n\n", test_count);                           \
+		test_passed++;                                                         \
+		return 1;                                                              \
+	} while (0)
+
+/* Record keyed by name, with a payload the comparison ignores */
+typedef struct record_s
+{
+	const char* name;
+	int value;
+} record_t;
+
+static int RecordCompare(record_t a, record_t b)
+{
+	return strcmp(a.name, b.name);
+}
+
+AVL_DEFINE(IntAVL, int, AVL_NUMERIC_CMP)
+AVL_DEFINE(RecordAVL, record_t, RecordCompare)
+
+/* Operation functions for ForEach testing */
+static int CheckOrderOp(int* key, void* arg)
+{
+	int* last = (int*) arg;
+	if (*key <= *last)
+		return 1;
+	*last = *key;
+	return 0;
+}
+
+static int SumValueOp(record_t* record, void* arg)
+{
+	*(int*) arg += record->value;
+	return 0;
+}
+
+int TestTypedBasic()
+{
+	IntAVL_t* tree = NULL;
+
+	TEST_START();
+
+	tree = IntAVLCreate();
+	TEST_ASSERT(tree != NULL, "Create should succeed");
+	TEST_ASSERT(IntAVLIsEmpty(tree), "New tree should be empty");
+	TEST_ASSERT(IntAVLFind(tree, 1) == NULL, "Find in empty tree fails");
+
+	TEST_ASSERT(IntAVLInsert(tree, 2) == 0, "Insert should succeed");
+	TEST_ASSERT(IntAVLInsert(tree, 1) == 0, "Insert should succeed");
+	TEST_ASSERT(IntAVLInsert(tree, 3) == 0, "Insert should succeed");
+	TEST_ASSERT(IntAVLInsert(tree, 2) != 0, "Duplicate insert should fail");
+	TEST_ASSERT(IntAVLCount(tree) == 3, "Count should be 3");
+	TEST_ASSERT(IntAVLHeight(tree) == 2, "Height should be 2");
+	TEST_ASSERT(IntAVLFind(tree, 3) && *IntAVLFind(tree, 3) == 3,
+	            "Find should return the stored key");
+
+	IntAVLRemove(tree, 2);
+	IntAVLRemove(tree, 7);
+	TEST_ASSERT(IntAVLCount(tree) == 2 && !IntAVLFind(tree, 2),
+	            "Remove should drop only the present key");
+
+	IntAVLDestroy(tree);
+	IntAVLDestroy(NULL);
+	TEST_END();
+}
+
+int TestTypedRandom()
+{
+	static char present[4096];
+	IntAVL_t* tree = NULL;
+	int i = 0;
+	int key = 0;
+	int ok = 1;
+	int last = -1;
+	size_t count = 0;
+
+	TEST_START();
+
+	tree = IntAVLCreate();
+	for (i = 0; i < 50000; i++)
+	{
+		key = rand() % 4096;
+		if (rand() % 3)
+		{
+			ok &= (IntAVLInsert(tree, key) == 0) == !present[key];
+			count += !present[key];
+			present[key] = 1;
+		}
+		else
+		{
+			IntAVLRemove(tree, key);
+			count -= present[key];
+			present[key] = 0;
+		}
+	}
+	TEST_ASSERT(ok, "Insert should fail exactly on duplicates");
+	TEST_ASSERT(IntAVLCount(tree) == count, "Count should match reference");
+	for (key = 0; key < 4096; key++)
+	{
+		ok &= (IntAVLFind(tree, key) != NULL) == present[key];
+	}
+	TEST_ASSERT(ok, "Membership should match reference");
+	TEST_ASSERT(IntAVLForEach(tree, CheckOrderOp, &last) == 0,
+	            "ForEach should visit keys in ascending order");
+	TEST_ASSERT(IntAVLHeight(tree) <= 17, "Tree should stay balanced");
+
+	IntAVLDestroy(tree);
+	TEST_END();
+}
+
+int TestTypedStruct()
+{
+	RecordAVL_t* tree = NULL;
+	record_t* found = NULL;
+	record_t key = {"banana", 0};
+	record_t records[] = {{"cherry", 3}, {"apple", 1}, {"banana", 2},
+	                      {"date", 4}};
+	int sum = 0;
+	int i = 0;
+
+	TEST_START();
+
+	tree = RecordAVLCreate();
+	for (i = 0; i < 4; i++)
+	{
+		RecordAVLInsert(tree, records[i]);
+	}
+	found = RecordAVLFind(tree, key);
+	TEST_ASSERT(found && found->value == 2, "Find should match on the key only");
+	found->value = 20;
+	RecordAVLForEach(tree, SumValueOp, &sum);
+	TEST_ASSERT(sum == 28, "Payload should be editable through Find");
+
+	RecordAVLRemove(tree, key);
+	TEST_ASSERT(RecordAVLCount(tree) == 3 && !RecordAVLFind(tree, key),
+	            "Struct key removal should work");
+
+	RecordAVLDestroy(tree);
+	TEST_END();
+}
+
+/* Main test runner */
+int main()
+{
+	printf("=== Typed AVL Tree Test Suite ===\n\n");
+
+	TestTypedBasic();
+	TestTypedRandom();
+	TestTypedStruct();
+
+	printf("=== Test Results ===\n");
+	printf("Tests run: %d\n", test_count);
+	printf("Tests passed: %d\n", test_passed);
+	printf("Tests failed: %d\n", test_count - test_passed);
+
+	if (test_passed == test_count)
+	{
+		printf("\n✅ All tests passed!\n");
+		return 0;
+	}
+	else
+	{
+		printf("\n⛔ Some tests failed!\n");
+		return 1;
+	}
+}
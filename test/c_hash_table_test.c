@@ -5,6 +5,7 @@
  *****************************************/
 
 #include "../include/c_hash_table.h"
+#include "../include/hash_funcs.h"
 #include <stdio.h>  /* printf */
 #include <stdlib.h> /* malloc, free */
 #include <string.h> /* strcmp, strcpy */
@@ -70,6 +71,23 @@ size_t TestDataHash(const void* key)
 	return (*(int*) key);
 }
 
+/* Calls made to the counting functions below */
+static size_t hash_calls = 0;
+static size_t cmp_calls = 0;
+
+/* IntHash and IntCmp that count their calls */
+size_t CountingIntHash(const void* key)
+{
+	++hash_calls;
+	return IntHash(key);
+}
+
+int CountingIntCmp(const void* data, const void* key)
+{
+	++cmp_calls;
+	return IntCmp(data, key);
+}
+
 /* Action function for counting elements */
 int CountAction(void* data, void* params)
 {
@@ -92,6 +110,12 @@ int PrintStrAction(void* data, void* params)
 	return 0;
 }
 
+/* Action function that fails with -1 at specific value */
+int FailAtValueAction(void* data, void* params)
+{
+	return (*(int*) data == *(int*) params) ? -1 : 0;
+}
+
 /* Action function that stops at specific value */
 int StopAtValueAction(void* data, void* params)
 {
@@ -296,6 +320,10 @@ void TestForeach()
 	result = Foreach(ht, StopAtValueAction, &stop_value);
 	assert(result == 1); /* Should return 1 when stopped early */
 
+	/* Any failure reads as 1, whatever the action returned */
+	result = Foreach(ht, FailAtValueAction, &stop_value);
+	assert(result == 1);
+
 	printf("Elements in hash table: ");
 	Foreach(ht, PrintIntAction, NULL);
 	printf("\n");
@@ -436,11 +464,352 @@ void TestEdgeCases()
 	printf("Edge cases tests passed!\n\n");
 }
 
+void TestResize()
+{
+	printf("Testing SetLoadLimits and Rehash functions...\n");
+
+	hash_table_t* ht = Create(IntCmp, IntHash, SMALL_TABLE_SIZE);
+	static int values[1000];
+
+	/* Off by default: the load just keeps climbing (see TestLoad) */
+	SetLoadLimits(ht, 2.0, 0.5);
+	for (int i = 0; i < 1000; i++)
+	{
+		values[i] = i;
+		assert(Insert(ht, &values[i]) == 0);
+		assert(Load(ht) <= 2.0);
+	}
+	assert(Size(ht) == 1000);
+	for (int i = 0; i < 1000; i++)
+	{
+		assert(Find(ht, &values[i]) == &values[i]);
+	}
+	printf("Load after growing: %.2f\n", Load(ht));
+
+	/* Shrinks after mass removal, but not below the created size */
+	for (int i = 0; i < 999; i++)
+	{
+		Remove(ht, &values[i]);
+		assert(Size(ht) < 10 || Load(ht) >= 0.5);
+	}
+	assert(Load(ht) == 1.0 / SMALL_TABLE_SIZE);
+	assert(Find(ht, &values[999]) == &values[999]);
+
+	/* Explicit rehash keeps every element */
+	for (int i = 0; i < 4; i++)
+	{
+		Insert(ht, &values[i]);
+	}
+	assert(Rehash(ht, 1) == 0);
+	assert(Load(ht) == 5.0);
+	int counter = 0;
+	Foreach(ht, CountAction, &counter);
+	assert(counter == 5);
+
+	Destroy(ht);
+	printf("SetLoadLimits and Rehash functions tests passed!\n\n");
+}
+
+void TestIncrementalRehash()
+{
+	printf("Testing incremental rehash...\n");
+
+	hash_table_t* ht = Create(IntCmp, IntHash, SMALL_TABLE_SIZE);
+	static int values[5000];
+	static int present[5000];
+	size_t expected_size = 0;
+
+	/* Random mix against a reference, resizing both ways on the way */
+	SetLoadLimits(ht, 1.0, 0.25);
+	for (int i = 0; i < 5000; i++)
+	{
+		values[i] = i;
+	}
+	for (int i = 0; i < 100000; i++)
+	{
+		int key = rand() % (i < 50000 ? 5000 : 500);
+		if (rand() % 2 && !present[key])
+		{
+			assert(Insert(ht, &values[key]) == 0);
+			present[key] = 1;
+			++expected_size;
+		}
+		else if (rand() % 2 && present[key])
+		{
+			Remove(ht, &values[key]);
+			present[key] = 0;
+			--expected_size;
+		}
+		assert((Find(ht, &values[key]) != NULL) == present[key]);
+	}
+	assert(Size(ht) == expected_size);
+	int counter = 0;
+	Foreach(ht, CountAction, &counter);
+	assert(counter == (int) expected_size);
+	for (int i = 0; i < 5000; i++)
+	{
+		assert((Find(ht, &values[i]) != NULL) == present[i]);
+	}
+
+	/* A resize left half done can be finished explicitly */
+	Destroy(ht);
+	ht = Create(IntCmp, IntHash, 100);
+	SetLoadLimits(ht, 1.0, 0);
+	for (int i = 0; i < 101; i++)
+	{
+		Insert(ht, &values[i]);
+	}
+	assert(RehashStep(ht, 1) == 1);
+	while (RehashStep(ht, 1))
+		;
+	assert(RehashStep(ht, 1) == 0);
+	for (int i = 0; i < 101; i++)
+	{
+		assert(Find(ht, &values[i]) == &values[i]);
+	}
+
+	Destroy(ht);
+	printf("Incremental rehash tests passed!\n\n");
+}
+
+void TestCachedHash()
+{
+	printf("Testing cached hashes...\n");
+
+	hash_table_t* ht = Create(CountingIntCmp, CountingIntHash, 1);
+	int values[100];
+	int missing = 1000;
+
+	for (int i = 0; i < 100; i++)
+	{
+		values[i] = i;
+		Insert(ht, &values[i]);
+	}
+	assert(hash_calls == 100);
+
+	/* One list holds everything, yet a miss compares no keys */
+	cmp_calls = 0;
+	assert(Find(ht, &missing) == NULL);
+	assert(cmp_calls == 0);
+	assert(Find(ht, &values[50]) == &values[50]);
+	assert(cmp_calls == 1);
+
+	/* Rehashing reuses the stored hashes */
+	hash_calls = 0;
+	assert(Rehash(ht, 64) == 0);
+	assert(hash_calls == 0);
+	for (int i = 0; i < 100; i++)
+	{
+		assert(Find(ht, &values[i]) == &values[i]);
+	}
+
+	Destroy(ht);
+	printf("Cached hash tests passed!\n\n");
+}
+
+void TestPowerOfTwo()
+{
+	printf("Testing power of 2 sizes with built-in hash functions...\n");
+
+	static int values[2000];
+	static char words[2000][16];
+	hash_stats_t stats;
+
+	/* Strided keys that an identity hash would pile into a few lists */
+	hash_table_t* ht = CreatePow2(IntCmp, HashInt, 64);
+	SetLoadLimits(ht, 1.0, 0.25);
+	for (int i = 0; i < 2000; i++)
+	{
+		values[i] = i * 1024;
+		assert(Insert(ht, &values[i]) == 0);
+	}
+	for (int i = 0; i < 2000; i++)
+	{
+		assert(Find(ht, &values[i]) == &values[i]);
+	}
+	for (int i = 0; i < 2000; i += 2)
+	{
+		Remove(ht, &values[i]);
+	}
+	for (int i = 0; i < 2000; i++)
+	{
+		assert((Find(ht, &values[i]) != NULL) == (i % 2));
+	}
+	Destroy(ht);
+
+	/* Strings, identity hashes and odd sizes still work */
+	ht = CreatePow2(StrCmp, HashStr, 100);
+	for (int i = 0; i < 2000; i++)
+	{
+		sprintf(words[i], "word%d", i);
+		Insert(ht, words[i]);
+	}
+	assert(Rehash(ht, 1000) == 0);
+	assert(Find(ht, "word1999") == words[1999]);
+	assert(Find(ht, "word2000") == NULL);
+	Destroy(ht);
+
+	ht = CreatePow2(IntCmp, IntHash, 1024);
+	for (int i = 0; i < 2000; i++)
+	{
+		Insert(ht, &values[i]);
+	}
+	assert(Find(ht, &values[1234]) == &values[1234]);
+	Destroy(ht);
+
+	/* Create keeps modulo for power of 2 sizes: consecutive ints, one per
+	list */
+	ht = Create(IntCmp, IntHash, 1024);
+	for (int i = 0; i < 1024; i++)
+	{
+		values[i] = i;
+		Insert(ht, &values[i]);
+	}
+	HashStats(ht, &stats);
+	assert(stats.max_length == 1);
+	assert(stats.empty == 0);
+	Destroy(ht);
+
+	/* CreatePow2 rounds up */
+	ht = CreatePow2(IntCmp, IntHash, 1000);
+	Insert(ht, &values[0]);
+	assert(Load(ht) == 1.0 / 1024);
+	Destroy(ht);
+
+	printf("Power of 2 tests passed!\n\n");
+}
+
+void TestStats()
+{
+	printf("Testing HashStats and SD functions...\n");
+
+	hash_table_t* ht = Create(IntCmp, IntHash, SMALL_TABLE_SIZE);
+	static int values[1000];
+	hash_stats_t stats;
+
+	/* Empty table */
+	HashStats(ht, &stats);
+	assert(stats.lists == SMALL_TABLE_SIZE && stats.elements == 0);
+	assert(stats.empty_ratio == 1.0 && stats.max_length == 0);
+	assert(SD(ht) == 0.0);
+
+	/* 0..9 modulo 5: two in every list */
+	for (int i = 0; i < 10; i++)
+	{
+		values[i] = i;
+		Insert(ht, &values[i]);
+	}
+	HashStats(ht, &stats);
+	assert(stats.histogram[2] == SMALL_TABLE_SIZE);
+	assert(stats.max_length == 2 && stats.sd == 0.0 && stats.empty == 0);
+
+	/* Five more in list 0: lengths 7,2,2,2,2 */
+	for (int i = 10; i < 35; i += 5)
+	{
+		values[i] = i;
+		Insert(ht, &values[i]);
+	}
+	HashStats(ht, &stats);
+	assert(stats.max_length == 7 && stats.histogram[7] == 1);
+	assert(stats.average == 3.0 && stats.sd == 2.0);
+	assert(SD(ht) == 2.0 / 15);
+
+	/* Counters follow removals */
+	for (int i = 10; i < 35; i += 5)
+	{
+		Remove(ht, &values[i]);
+	}
+	Remove(ht, &values[0]);
+	Remove(ht, &values[5]);
+	HashStats(ht, &stats);
+	assert(stats.empty == 1 && stats.histogram[0] == 1);
+	assert(stats.histogram[2] == 4 && stats.elements == 8);
+	Destroy(ht);
+
+	/* Mid resize both arrays count, and the histogram adds up */
+	ht = Create(IntCmp, IntHash, 100);
+	SetLoadLimits(ht, 1.0, 0);
+	for (int i = 0; i < 1000; i++)
+	{
+		values[i] = i;
+		Insert(ht, &values[i]);
+	}
+	RehashStep(ht, 10);
+	HashStats(ht, &stats);
+	size_t total = 0;
+	for (int i = 0; i < HASH_HISTOGRAM_SIZE; i++)
+	{
+		total += stats.histogram[i];
+	}
+	assert(total == stats.lists && stats.elements == 1000);
+	printf("Lists %zu, longest %zu, sd %.2f, empty %.2f\n", stats.lists,
+	       stats.max_length, stats.sd, stats.empty_ratio);
+
+	Destroy(ht);
+	printf("HashStats and SD functions tests passed!\n\n");
+}
+
+void TestLoadDicFile()
+{
+	printf("Testing LoadDicFile function...\n");
+
+	const char* path = "hash_table_test_words.txt";
+	char word[MAX_WORD_SIZE];
+	FILE* file = fopen(path, "w");
+	assert(file != NULL);
+	fputs("apple\nbanana\r\n\ncherry\n\ndate", file);
+	fclose(file);
+
+	/* Line endings, empty lines and a last line with no newline */
+	hash_table_t* ht = Create(StrCmp, HashStr, SMALL_TABLE_SIZE);
+	dictionary_t* dictionary = LoadDicFile(ht, path, 1);
+	assert(dictionary != NULL);
+	assert(Size(ht) == 4);
+	assert(Find(ht, "apple") && Find(ht, "banana"));
+	assert(Find(ht, "cherry") && Find(ht, "date"));
+	assert(Find(ht, "banana\r") == NULL && Find(ht, "") == NULL);
+	Destroy(ht);
+	FreeDic(dictionary);
+
+	/* Many words hashed on several threads, table sized up front */
+	file = fopen(path, "w");
+	for (int i = 0; i < 50000; i++)
+	{
+		fprintf(file, "word%d\n", i);
+	}
+	fclose(file);
+	ht = Create(StrCmp, HashStr, 64);
+	Insert(ht, "extra");
+	dictionary = LoadDicFile(ht, path, 4);
+	assert(dictionary != NULL);
+	assert(Size(ht) == 50001 && Load(ht) <= 1.0);
+	for (int i = 0; i < 50000; i += 7)
+	{
+		sprintf(word, "word%d", i);
+		assert(Find(ht, word) != NULL);
+		assert(strcmp((char*) Find(ht, word), word) == 0);
+	}
+	assert(Find(ht, "extra") != NULL);
+	Destroy(ht);
+	FreeDic(dictionary);
+
+	/* Missing file leaves the table alone */
+	remove(path);
+	ht = Create(StrCmp, HashStr, SMALL_TABLE_SIZE);
+	assert(LoadDicFile(ht, path, 1) == NULL);
+	assert(IsEmpty(ht) && Load(ht) == 0.0);
+	Destroy(ht);
+	FreeDic(NULL);
+
+	printf("LoadDicFile function tests passed!\n\n");
+}
+
 void SpellChecker()
 {
 	char word[MAX_WORD_SIZE];
-	hash_table_t* ht = Create(StrCmp, StrHash, TABLE_SIZE);
+	hash_table_t* ht = Create(StrCmp, HashStr, TABLE_SIZE);
 
+	SetLoadLimits(ht, 1.0, 0.25);
 	LoadDic(ht);
 
 	while (1)
@@ -476,6 +845,12 @@ void RunAllTests()
 	TestStringHashTable();
 	TestComplexData();
 	TestEdgeCases();
+	TestResize();
+	TestIncrementalRehash();
+	TestCachedHash();
+	TestPowerOfTwo();
+	TestStats();
+	TestLoadDicFile();
 
 	printf("========== ALL TESTS PASSED! ==========\n");
 
@@ -0,0 +1,204 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+/*
+    Throughput of concurrent_hash_table_t against hash_table_t behind one
+    global mutex, for a read-mostly mix (90% Find) and a 50/50 mix of Find
+    and updates (Remove then Insert of a key the thread owns).
+
+    gcc -O2 -Iinclude src/c_hash_table.c src/concurrent_hash_table.c src/hash_funcs.c test/concurrent_hash_bench.c -pthread -lm -o bin/release/concurrent_hash_bench.out
+    ./bin/release/concurrent_hash_bench.out [max_threads]
+*/
+
+#include <stdio.h>   /* printf */
+#include <stdlib.h>  /* malloc, free, atoi, rand_r */
+#include <time.h>    /* clock_gettime */
+#include <unistd.h>  /* sysconf */
+#include <sched.h>   /* sched_yield */
+#include <pthread.h>
+
+#include "../include/c_hash_table.h"
+#include "../include/concurrent_hash_table.h"
+#include "../include/hash_funcs.h"
+
+#define BENCH_KEYS (1 << 20)
+#define BENCH_SECONDS (0.5)
+
+typedef struct bench
+{
+	hash_table_t* locked;                /* NULL for the concurrent table */
+	pthread_mutex_t* lock;
+	concurrent_hash_table_t* concurrent;
+	int* keys;
+	int update_percent;
+	int threads;
+	int stop;
+} bench_t;
+
+typedef struct worker
+{
+	bench_t* bench;
+	int id;
+	size_t ops;
+	pthread_t thread;
+} worker_t;
+
+static int IntCmp(const void* data, const void* key)
+{
+	return *(const int*) data == *(const int*) key;
+}
+
+static double Now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void Find1(bench_t* bench, int* key)
+{
+	if (bench->locked)
+	{
+		pthread_mutex_lock(bench->lock);
+		Find(bench->locked, key);
+		pthread_mutex_unlock(bench->lock);
+	}
+	else
+	{
+		ConcurrentHashFind(bench->concurrent, key);
+	}
+}
+
+/* key stays in the table; only its owner touches it, so no duplicates */
+static void Update1(bench_t* bench, int* key)
+{
+	if (bench->locked)
+	{
+		pthread_mutex_lock(bench->lock);
+		Remove(bench->locked, key);
+		Insert(bench->locked, key);
+		pthread_mutex_unlock(bench->lock);
+	}
+	else
+	{
+		ConcurrentHashRemove(bench->concurrent, key);
+		ConcurrentHashInsert(bench->concurrent, key);
+	}
+}
+
+static void* Worker(void* arg)
+{
+	worker_t* worker = (worker_t*) arg;
+	bench_t* bench = worker->bench;
+	unsigned seed = (unsigned) worker->id + 1;
+	size_t ops = 0;
+	int owned = BENCH_KEYS / bench->threads;
+	int i = 0;
+
+	while (!__atomic_load_n(&bench->stop, __ATOMIC_RELAXED))
+	{
+		for (i = 0; i < 256; i++)
+		{
+			if ((int) (rand_r(&seed) % 100) < bench->update_percent)
+				Update1(bench, &bench->keys[worker->id +
+				                            (rand_r(&seed) % owned) *
+				                                bench->threads]);
+			else
+				Find1(bench, &bench->keys[rand_r(&seed) % BENCH_KEYS]);
+		}
+		ops += 256;
+	}
+	worker->ops = ops;
+	return NULL;
+}
+
+/* returns millions of operations per second over all threads */
+static double Run(bench_t* bench, int nthreads)
+{
+	worker_t* workers = malloc(sizeof(worker_t) * nthreads);
+	size_t total = 0;
+	double start = 0.0;
+	double elapsed = 0.0;
+	int i = 0;
+
+	bench->stop = 0;
+	bench->threads = nthreads;
+	for (i = 0; i < nthreads; i++)
+	{
+		workers[i].bench = bench;
+		workers[i].id = i;
+		pthread_create(&workers[i].thread, NULL, Worker, &workers[i]);
+	}
+
+	start = Now();
+	while (Now() - start < BENCH_SECONDS)
+		sched_yield();
+	__atomic_store_n(&bench->stop, 1, __ATOMIC_RELAXED);
+
+	for (i = 0; i < nthreads; i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+		total += workers[i].ops;
+	}
+	elapsed = Now() - start;
+
+	free(workers);
+	return (double) total / elapsed / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+	int max_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	int* keys = malloc(sizeof(int) * BENCH_KEYS);
+	int mixes[] = {10, 50};
+	pthread_mutex_t lock;
+	bench_t locked = {0};
+	bench_t concurrent = {0};
+	int i = 0;
+	int m = 0;
+	int n = 0;
+
+	if (argc > 1)
+		max_threads = atoi(argv[1]);
+	if (max_threads < 1)
+		max_threads = 1;
+
+	pthread_mutex_init(&lock, NULL);
+	locked.locked = Create(IntCmp, HashInt, BENCH_KEYS);
+	locked.lock = &lock;
+	locked.keys = keys;
+	concurrent.concurrent = ConcurrentHashCreate(IntCmp, HashInt, BENCH_KEYS);
+	concurrent.keys = keys;
+
+	for (i = 0; i < BENCH_KEYS; i++)
+	{
+		keys[i] = i;
+		Insert(locked.locked, &keys[i]);
+		ConcurrentHashInsert(concurrent.concurrent, &keys[i]);
+	}
+
+	printf("%d keys, %.1fs per run (Mops/s)\n", BENCH_KEYS, BENCH_SECONDS);
+	for (m = 0; m < 2; m++)
+	{
+		locked.update_percent = mixes[m];
+		concurrent.update_percent = mixes[m];
+		printf("%d%% Find, %d%% update\n", 100 - mixes[m], mixes[m]);
+		printf("%8s %14s %14s\n", "threads", "global mutex", "concurrent");
+		for (n = 1; n <= max_threads; n *= 2)
+		{
+			printf("%8d %14.2f %14.2f\n", n, Run(&locked, n),
+			       Run(&concurrent, n));
+			if (n < max_threads && n * 2 > max_threads)
+				n = max_threads / 2;
+		}
+	}
+
+	Destroy(locked.locked);
+	ConcurrentHashDestroy(concurrent.concurrent);
+	pthread_mutex_destroy(&lock);
+	free(keys);
+	return 0;
+}
@@ -0,0 +1,240 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+#include "../include/concurrent_hash_table.h"
+#include "../include/hash_funcs.h"
+#include <stdio.h>   /* printf */
+#include <stdlib.h>  /* rand_r */
+#include <string.h>  /* strcmp */
+#include <assert.h>  /* assert */
+#include <pthread.h> /* pthread_create, pthread_join */
+
+#define TEST_SIZE 10
+#define THREAD_KEYS 20000
+#define WRITERS 4
+#define READERS 4
+
+/*========================== HELPER FUNCTIONS ============================*/
+
+/* Comparison function for integers */
+int IntCmp(const void* data, const void* key)
+{
+	return (*(int*) data == *(int*) key);
+}
+
+/* Action function for summing integers */
+int SumAction(void* data, void* params)
+{
+	*(long*) params += *(int*) data;
+	return 0;
+}
+
+/* Action function that stops at specific value */
+int StopAtValueAction(void* data, void* params)
+{
+	return *(int*) data == *(int*) params;
+}
+
+/* Keys shared by the threads: [0, THREAD_KEYS) stay in the table, each
+writer churns its own slice above that */
+static int keys[THREAD_KEYS * (WRITERS + 1)];
+static int stop_readers = 0;
+
+typedef struct worker
+{
+	concurrent_hash_table_t* ht;
+	int id;
+	size_t misses;
+	pthread_t thread;
+} worker_t;
+
+/* Insert and remove the worker's slice, leaving every other key in */
+void* Writer(void* arg)
+{
+	worker_t* worker = (worker_t*) arg;
+	int* slice = &keys[THREAD_KEYS * (worker->id + 1)];
+	int round = 0;
+	int i = 0;
+
+	for (round = 0; round < 3; round++)
+	{
+		for (i = 0; i < THREAD_KEYS; i++)
+		{
+			if (ConcurrentHashInsert(worker->ht, &slice[i]))
+				++worker->misses;
+		}
+		for (i = 0; i < THREAD_KEYS; i++)
+		{
+			if (round == 2 && i % 2)
+				continue;
+			if (ConcurrentHashRemove(worker->ht, &slice[i]) != &slice[i])
+				++worker->misses;
+		}
+	}
+
+	return NULL;
+}
+
+/* Look up keys that are never removed, through growth and removals */
+void* Reader(void* arg)
+{
+	worker_t* worker = (worker_t*) arg;
+	unsigned seed = (unsigned) worker->id;
+	int* key = NULL;
+
+	while (!__atomic_load_n(&stop_readers, __ATOMIC_RELAXED))
+	{
+		key = &keys[rand_r(&seed) % THREAD_KEYS];
+		if (ConcurrentHashFind(worker->ht, key) != key)
+			++worker->misses;
+	}
+
+	return NULL;
+}
+
+/*============================= TEST FUNCTIONS =============================*/
+
+void TestBasic()
+{
+	int values[] = {1, 2, 3, 4, 5};
+	int missing = 999;
+	int stop_value = 3;
+	int same_value = 42;
+	long sum = 0;
+	concurrent_hash_table_t* ht = NULL;
+	int i = 0;
+
+	printf("Testing basic operations...\n");
+
+	ht = ConcurrentHashCreate(IntCmp, HashInt, TEST_SIZE);
+	assert(ht != NULL);
+	assert(ConcurrentHashIsEmpty(ht) == 1);
+	assert(ConcurrentHashFind(ht, &missing) == NULL);
+
+	for (i = 0; i < 5; i++)
+	{
+		assert(ConcurrentHashInsert(ht, &values[i]) == 0);
+		assert(ConcurrentHashSize(ht) == (size_t) i + 1);
+	}
+	for (i = 0; i < 5; i++)
+		assert(ConcurrentHashFind(ht, &values[i]) == &values[i]);
+	assert(ConcurrentHashFind(ht, &missing) == NULL);
+	assert(ConcurrentHashLoad(ht) == 5.0 / 64);
+
+	ConcurrentHashForeach(ht, SumAction, &sum);
+	assert(sum == 15);
+	assert(ConcurrentHashForeach(ht, StopAtValueAction, &stop_value) == 1);
+
+	assert(ConcurrentHashRemove(ht, &values[2]) == &values[2]);
+	assert(ConcurrentHashRemove(ht, &missing) == NULL);
+	assert(ConcurrentHashSize(ht) == 4);
+	assert(ConcurrentHashFind(ht, &values[2]) == NULL);
+	ConcurrentHashSynchronize(ht);
+
+	/* Duplicates are allowed, as in the chained table */
+	for (i = 0; i < 3; i++)
+		ConcurrentHashInsert(ht, &same_value);
+	assert(ConcurrentHashRemove(ht, &same_value) == &same_value);
+	assert(ConcurrentHashSize(ht) == 6);
+
+	ConcurrentHashDestroy(ht);
+	ConcurrentHashDestroy(NULL);
+	printf("Basic operations tests passed!\n\n");
+}
+
+void TestGrowth()
+{
+	concurrent_hash_table_t* ht = NULL;
+	int i = 0;
+
+	printf("Testing growth...\n");
+
+	ht = ConcurrentHashCreate(IntCmp, HashInt, 0);
+	for (i = 0; i < THREAD_KEYS; i++)
+	{
+		keys[i] = i;
+		assert(ConcurrentHashInsert(ht, &keys[i]) == 0);
+	}
+	assert(ConcurrentHashSize(ht) == THREAD_KEYS);
+	assert(ConcurrentHashLoad(ht) <= 1.0);
+	for (i = 0; i < THREAD_KEYS; i++)
+		assert(ConcurrentHashFind(ht, &keys[i]) == &keys[i]);
+
+	/* Removals past a retire batch free entries along the way */
+	for (i = 0; i < THREAD_KEYS; i += 2)
+		assert(ConcurrentHashRemove(ht, &keys[i]) == &keys[i]);
+	for (i = 0; i < THREAD_KEYS; i++)
+		assert((ConcurrentHashFind(ht, &keys[i]) != NULL) == (i % 2));
+
+	ConcurrentHashDestroy(ht);
+	printf("Growth tests passed!\n\n");
+}
+
+void TestThreads()
+{
+	worker_t writers[WRITERS];
+	worker_t readers[READERS];
+	concurrent_hash_table_t* ht = NULL;
+	size_t i = 0;
+
+	printf("Testing concurrent inserts, removes and finds...\n");
+
+	ht = ConcurrentHashCreate(IntCmp, HashInt, 0);
+	for (i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+		keys[i] = (int) i;
+	for (i = 0; i < THREAD_KEYS; i++)
+		ConcurrentHashInsert(ht, &keys[i]);
+
+	for (i = 0; i < READERS; i++)
+	{
+		readers[i].ht = ht;
+		readers[i].id = (int) i + 1;
+		readers[i].misses = 0;
+		pthread_create(&readers[i].thread, NULL, Reader, &readers[i]);
+	}
+	for (i = 0; i < WRITERS; i++)
+	{
+		writers[i].ht = ht;
+		writers[i].id = (int) i;
+		writers[i].misses = 0;
+		pthread_create(&writers[i].thread, NULL, Writer, &writers[i]);
+	}
+
+	for (i = 0; i < WRITERS; i++)
+	{
+		pthread_join(writers[i].thread, NULL);
+		assert(writers[i].misses == 0);
+	}
+	__atomic_store_n(&stop_readers, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < READERS; i++)
+	{
+		pthread_join(readers[i].thread, NULL);
+		assert(readers[i].misses == 0);
+	}
+
+	/* Each writer left the odd half of its slice in */
+	assert(ConcurrentHashSize(ht) == THREAD_KEYS + WRITERS * THREAD_KEYS / 2);
+	for (i = THREAD_KEYS; i < sizeof(keys) / sizeof(keys[0]); i++)
+		assert((ConcurrentHashFind(ht, &keys[i]) != NULL) == (i % 2));
+
+	ConcurrentHashSynchronize(ht);
+	ConcurrentHashDestroy(ht);
+	printf("Concurrent tests passed!\n\n");
+}
+
+/*================================= MAIN ==================================*/
+
+int main()
+{
+	printf("========== CONCURRENT HASH TABLE TESTS ==========\n\n");
+
+	TestBasic();
+	TestGrowth();
+	TestThreads();
+
+	printf("========== ALL TESTS PASSED! ==========\n");
+	return 0;
+}
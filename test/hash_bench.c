@@ -0,0 +1,259 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+/*
+    Chain length distribution of the hash functions in hash_funcs.h against
+    the naive ones in c_hash_table_test.c, for modulo, plain mask and
+    multiply-shift list indexing, then lookup time through hash_table_t.
+
+    gcc -O2 -Iinclude src/c_hash_table.c src/hash_funcs.c test/hash_bench.c -pthread -lm -o bin/release/hash_bench.out
+    ./bin/release/hash_bench.out [words_file]
+*/
+
+#include <stdio.h>  /* printf, fopen, fgets */
+#include <stdlib.h> /* malloc, free */
+#include <string.h> /* strcmp, strcspn */
+#include <stdint.h> /* uint64_t */
+#include <time.h>   /* clock_gettime */
+
+#include "../include/c_hash_table.h"
+#include "../include/hash_funcs.h"
+
+#define BENCH_KEYS (1 << 17)
+#define BENCH_LISTS (1 << 17)
+#define BENCH_MODULO_LISTS (100003)
+#define HISTOGRAM_MAX (8)
+#define WORD_SIZE (32)
+
+/* Same constant hash_table_t multiplies by for power of 2 sizes */
+#define FIBONACCI_MULTIPLIER (0x9E3779B97F4A7C15ULL)
+
+typedef enum index_mode
+{
+	MODULO,
+	MASK,
+	MULTIPLY_SHIFT
+} index_mode_t;
+
+static const char* mode_names[] = {"modulo", "mask", "mul-shift"};
+
+typedef struct key_set
+{
+	const char* name;
+	void** keys;
+	size_t count;
+	hash_func_t naive_hash;
+	const char* naive_name;
+	hash_func_t good_hash;
+	const char* good_name;
+	cmp_func_t cmp;
+} key_set_t;
+
+/*========================== HELPER FUNCTIONS ============================*/
+
+static size_t IdentityHash(const void* key)
+{
+	return (size_t) *(const int*) key;
+}
+
+static size_t Poly31Hash(const void* key)
+{
+	const char* str = (const char*) key;
+	size_t hash = 0;
+	while (*str)
+	{
+		hash = hash * 31 + (unsigned char) *str;
+		str++;
+	}
+	return hash;
+}
+
+static int IntCmp(const void* data, const void* key)
+{
+	return *(const int*) data == *(const int*) key;
+}
+
+static int StrCmp(const void* data, const void* key)
+{
+	return strcmp((const char*) data, (const char*) key) == 0;
+}
+
+static double Now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static size_t Index(size_t hash, size_t lists, index_mode_t mode)
+{
+	unsigned shift = 64;
+	size_t size = lists;
+
+	if (MODULO == mode)
+		return hash % lists;
+	if (MASK == mode)
+		return hash & (lists - 1);
+
+	while (1 < size)
+	{
+		size >>= 1;
+		--shift;
+	}
+	return (size_t) (((uint64_t) hash * FIBONACCI_MULTIPLIER) >> shift);
+}
+
+/* One line: lists with 0..7 and 8+ elements, the longest, and the mean
+number of elements a successful lookup walks */
+static void Distribution(const key_set_t* set, hash_func_t hash,
+                         const char* hash_name, index_mode_t mode)
+{
+	size_t lists = (MODULO == mode) ? BENCH_MODULO_LISTS : BENCH_LISTS;
+	size_t* lengths = (size_t*) calloc(lists, sizeof(size_t));
+	size_t histogram[HISTOGRAM_MAX + 1] = {0};
+	size_t longest = 0;
+	double walked = 0;
+	size_t i = 0;
+
+	for (i = 0; i < set->count; i++)
+		++lengths[Index(hash(set->keys[i]), lists, mode)];
+
+	for (i = 0; i < lists; i++)
+	{
+		++histogram[lengths[i] < HISTOGRAM_MAX ? lengths[i] : HISTOGRAM_MAX];
+		longest = lengths[i] > longest ? lengths[i] : longest;
+		walked += (double) lengths[i] * (double) (lengths[i] + 1) / 2;
+	}
+
+	printf("%-8s %-10s %-9s", set->name, hash_name, mode_names[mode]);
+	for (i = 0; i <= HISTOGRAM_MAX; i++)
+		printf(" %7.3f", (double) histogram[i] / (double) lists);
+	printf(" %6zu %6.2f\n", longest, walked / (double) set->count);
+
+	free(lengths);
+}
+
+/* Nanoseconds per Find over every key, after inserting them all, with
+modulo or multiply-shift indexing */
+static double LookupTime(const key_set_t* set, hash_func_t hash,
+                         index_mode_t mode)
+{
+	hash_table_t* table = (MODULO == mode)
+	                          ? Create(set->cmp, hash, BENCH_MODULO_LISTS)
+	                          : CreatePow2(set->cmp, hash, BENCH_LISTS);
+	size_t found = 0;
+	double start = 0;
+	size_t i = 0;
+	int round = 0;
+
+	for (i = 0; i < set->count; i++)
+		Insert(table, set->keys[i]);
+
+	start = Now();
+	for (round = 0; round < 4; round++)
+	{
+		for (i = 0; i < set->count; i++)
+			found += NULL != Find(table, set->keys[i]);
+	}
+	start = (Now() - start) * 1e9 / (double) found;
+
+	Destroy(table);
+	return start;
+}
+
+static void RunSet(const key_set_t* set)
+{
+	index_mode_t mode = MODULO;
+
+	for (mode = MODULO; mode <= MULTIPLY_SHIFT; mode++)
+	{
+		Distribution(set, set->naive_hash, set->naive_name, mode);
+		Distribution(set, set->good_hash, set->good_name, mode);
+	}
+
+	printf("%-8s Find ns: %s %.1f/%.1f, %s %.1f/%.1f (modulo/mul-shift)\n\n",
+	       set->name, set->naive_name,
+	       LookupTime(set, set->naive_hash, MODULO),
+	       LookupTime(set, set->naive_hash, MULTIPLY_SHIFT), set->good_name,
+	       LookupTime(set, set->good_hash, MODULO),
+	       LookupTime(set, set->good_hash, MULTIPLY_SHIFT));
+}
+
+/* Lines of path, at most BENCH_KEYS, into words; the count read */
+static size_t ReadWords(const char* path, char (*words)[WORD_SIZE])
+{
+	FILE* file = fopen(path, "r");
+	size_t count = 0;
+
+	if (NULL == file)
+		return 0;
+	while (count < BENCH_KEYS && fgets(words[count], WORD_SIZE, file))
+	{
+		words[count][strcspn(words[count], "\n")] = '\0';
+		++count;
+	}
+	fclose(file);
+	return count;
+}
+
+/*================================= MAIN ==================================*/
+
+int main(int argc, char** argv)
+{
+	static int ints[BENCH_KEYS];
+	static char words[BENCH_KEYS][WORD_SIZE];
+	static void* keys[BENCH_KEYS];
+	key_set_t set = {0};
+	size_t i = 0;
+	int stride = 0;
+
+	printf("%d keys, %d lists (modulo) or %d (power of 2)\n", BENCH_KEYS,
+	       BENCH_MODULO_LISTS, BENCH_LISTS);
+	printf("%-8s %-10s %-9s", "keys", "hash", "index");
+	for (i = 0; i < HISTOGRAM_MAX; i++)
+		printf(" %6zu:", i);
+	printf(" %6d+: %6s %6s\n", HISTOGRAM_MAX, "max", "walked");
+
+	/* Integers, consecutive and strided */
+	set.keys = keys;
+	set.count = BENCH_KEYS;
+	set.naive_hash = IdentityHash;
+	set.naive_name = "identity";
+	set.good_hash = HashInt;
+	set.good_name = "HashInt";
+	set.cmp = IntCmp;
+	for (stride = 1; stride <= 1024; stride *= 1024)
+	{
+		for (i = 0; i < BENCH_KEYS; i++)
+		{
+			ints[i] = (int) i * stride;
+			keys[i] = &ints[i];
+		}
+		set.name = (1 == stride) ? "ints" : "ints*1K";
+		RunSet(&set);
+	}
+
+	/* Strings: a dictionary if given, generated words otherwise */
+	set.count = (1 < argc) ? ReadWords(argv[1], words) : 0;
+	set.name = "dict";
+	if (0 == set.count)
+	{
+		for (i = 0; i < BENCH_KEYS; i++)
+			sprintf(words[i], "key%zu", i);
+		set.count = BENCH_KEYS;
+		set.name = "words";
+	}
+	for (i = 0; i < set.count; i++)
+		keys[i] = words[i];
+	set.naive_hash = Poly31Hash;
+	set.naive_name = "poly31";
+	set.good_hash = HashStr;
+	set.good_name = "HashStr";
+	set.cmp = StrCmp;
+	RunSet(&set);
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+#include "../include/hash_funcs.h"
+#include <stdio.h>  /* printf */
+#include <string.h> /* memset */
+#include <assert.h> /* assert */
+
+#define BUCKETS 64
+#define KEYS (BUCKETS * 100)
+
+/*============================= TEST FUNCTIONS =============================*/
+
+void TestHashInt()
+{
+	size_t counts[BUCKETS];
+	int key = 0;
+	int other = 0;
+	int i = 0;
+
+	printf("Testing HashInt and HashU64 functions...\n");
+
+	/* Same key, same hash; the value behind the pointer is what counts */
+	key = 42;
+	other = 42;
+	assert(HashInt(&key) == HashInt(&other));
+	assert(HashInt(&key) == HashU64(42));
+	assert(HashU64(0) != HashU64(1));
+
+	/* Keys 1024 apart fill low bit buckets evenly */
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < KEYS; i++)
+	{
+		key = i * 1024;
+		++counts[HashInt(&key) & (BUCKETS - 1)];
+	}
+	for (i = 0; i < BUCKETS; i++)
+	{
+		assert(counts[i] > 50 && counts[i] < 150);
+	}
+
+	printf("HashInt and HashU64 functions tests passed!\n\n");
+}
+
+void TestHashPtr()
+{
+	static int objects[KEYS];
+	size_t counts[BUCKETS];
+	int i = 0;
+
+	printf("Testing HashPtr function...\n");
+
+	/* The address is hashed, not what it points at */
+	assert(HashPtr(&objects[0]) == HashPtr(&objects[0]));
+	assert(HashPtr(&objects[0]) != HashPtr(&objects[1]));
+	assert(HashPtr(NULL) == HashU64(0));
+
+	/* Aligned addresses share their low bits, the hashes don't */
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < KEYS; i++)
+	{
+		++counts[HashPtr(&objects[i]) & (BUCKETS - 1)];
+	}
+	for (i = 0; i < BUCKETS; i++)
+	{
+		assert(counts[i] > 50 && counts[i] < 150);
+	}
+
+	printf("HashPtr function tests passed!\n\n");
+}
+
+void TestHashBytes()
+{
+	unsigned char buffer[200];
+	size_t len = 0;
+	size_t hash = 0;
+	size_t i = 0;
+
+	printf("Testing HashBytes and HashStr functions...\n");
+
+	for (i = 0; i < sizeof(buffer); i++)
+	{
+		buffer[i] = (unsigned char) i;
+	}
+
+	/* Every byte of every length matters, across all the code paths */
+	for (len = 0; len < sizeof(buffer); len++)
+	{
+		hash = HashBytes(buffer, len, 0);
+		assert(hash == HashBytes(buffer, len, 0));
+		assert(hash != HashBytes(buffer, len, 1));
+		assert(len == 0 || hash != HashBytes(buffer, len - 1, 0));
+		for (i = 0; i < len; i++)
+		{
+			buffer[i] ^= 1;
+			assert(hash != HashBytes(buffer, len, 0));
+			buffer[i] ^= 1;
+		}
+	}
+	assert(HashBytes(NULL, 0, 0) == HashBytes(buffer, 0, 0));
+
+	/* HashStr is HashBytes of the characters */
+	assert(HashStr("hello") == HashBytes("hello", 5, 0));
+	assert(HashStr("") == HashBytes("", 0, 0));
+	assert(HashStr("ab") != HashStr("ba"));
+
+	printf("HashBytes and HashStr functions tests passed!\n\n");
+}
+
+/*================================= MAIN ==================================*/
+
+int main()
+{
+	printf("========== HASH FUNCTIONS TESTS ==========\n\n");
+
+	TestHashInt();
+	TestHashPtr();
+	TestHashBytes();
+
+	printf("========== ALL TESTS PASSED! ==========\n");
+	return 0;
+}
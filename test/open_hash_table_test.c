@@ -0,0 +1,311 @@
+/*****************************************
+ * date: Thu Jun 05 2025                 *
+ * name: Shoval Elhaiany                 *
+ * code reviewer: Ofir Cohen             *
+ *****************************************/
+
+#include "../include/open_hash_table.h"
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* rand */
+#include <string.h> /* strcmp */
+#include <assert.h> /* assert */
+
+#define TEST_SIZE 10
+#define RANDOM_KEYS 5000
+
+/*========================== HELPER FUNCTIONS ============================*/
+
+/* Comparison function for integers */
+int IntCmp(const void* data, const void* key)
+{
+	return (*(int*) data == *(int*) key);
+}
+
+/* Comparison function for strings */
+int StrCmp(const void* data, const void* key)
+{
+	return strcmp((char*) data, (char*) key) == 0;
+}
+
+/* Identity hash, the worst case for a power of 2 table without mixing */
+size_t IntHash(const void* key)
+{
+	return (size_t) (*(int*) key);
+}
+
+/* Every key in one probe sequence */
+size_t ConstHash(const void* key)
+{
+	(void) key;
+	return 42;
+}
+
+/* Simple hash function for strings */
+size_t StrHash(const void* key)
+{
+	char* str = (char*) key;
+	size_t hash = 0;
+	while (*str)
+	{
+		hash = hash * 31 + *str;
+		str++;
+	}
+	return hash;
+}
+
+/* Calls made to the counting functions below */
+static size_t hash_calls = 0;
+static size_t cmp_calls = 0;
+
+/* IntHash and IntCmp that count their calls */
+size_t CountingIntHash(const void* key)
+{
+	++hash_calls;
+	return IntHash(key);
+}
+
+int CountingIntCmp(const void* data, const void* key)
+{
+	++cmp_calls;
+	return IntCmp(data, key);
+}
+
+/* Action function for summing integers */
+int SumAction(void* data, void* params)
+{
+	*(long*) params += *(int*) data;
+	return 0;
+}
+
+/* Action function that stops at specific value */
+int StopAtValueAction(void* data, void* params)
+{
+	return *(int*) data == *(int*) params;
+}
+
+/*============================= TEST FUNCTIONS =============================*/
+
+void TestBasic()
+{
+	int values[] = {1, 2, 3, 4, 5};
+	int missing = 999;
+	int stop_value = 3;
+	long sum = 0;
+	open_hash_table_t* ht = NULL;
+	int i = 0;
+
+	printf("Testing basic operations...\n");
+
+	ht = OpenHashCreate(IntCmp, IntHash, TEST_SIZE);
+	assert(ht != NULL);
+	assert(OpenHashIsEmpty(ht) == 1);
+	assert(OpenHashFind(ht, &missing) == NULL);
+
+	for (i = 0; i < 5; i++)
+	{
+		assert(OpenHashInsert(ht, &values[i]) == 0);
+		assert(OpenHashSize(ht) == (size_t) i + 1);
+	}
+	for (i = 0; i < 5; i++)
+	{
+		assert(OpenHashFind(ht, &values[i]) == &values[i]);
+	}
+	assert(OpenHashFind(ht, &missing) == NULL);
+	assert(OpenHashLoad(ht) == 5.0 / 16);
+
+	OpenHashForeach(ht, SumAction, &sum);
+	assert(sum == 15);
+	assert(OpenHashForeach(ht, StopAtValueAction, &stop_value) == 1);
+
+	OpenHashRemove(ht, &values[2]);
+	OpenHashRemove(ht, &missing);
+	assert(OpenHashSize(ht) == 4);
+	assert(OpenHashFind(ht, &values[2]) == NULL);
+
+	OpenHashDestroy(ht);
+	OpenHashDestroy(NULL);
+	printf("Basic operations tests passed!\n\n");
+}
+
+void TestGrowth()
+{
+	static int values[RANDOM_KEYS];
+	open_hash_table_t* ht = NULL;
+	int i = 0;
+
+	printf("Testing growth...\n");
+
+	ht = OpenHashCreate(IntCmp, IntHash, 0);
+	for (i = 0; i < RANDOM_KEYS; i++)
+	{
+		values[i] = i * 1024; /* same low bits everywhere */
+		assert(OpenHashInsert(ht, &values[i]) == 0);
+	}
+	assert(OpenHashSize(ht) == RANDOM_KEYS);
+	assert(OpenHashLoad(ht) <= 7.0 / 8);
+	for (i = 0; i < RANDOM_KEYS; i++)
+	{
+		assert(OpenHashFind(ht, &values[i]) == &values[i]);
+	}
+
+	OpenHashDestroy(ht);
+	printf("Growth tests passed!\n\n");
+}
+
+void TestRandom()
+{
+	static int values[RANDOM_KEYS];
+	static int present[RANDOM_KEYS];
+	open_hash_table_t* ht = NULL;
+	size_t count = 0;
+	int key = 0;
+	int i = 0;
+
+	printf("Testing random inserts and removes...\n");
+
+	ht = OpenHashCreate(IntCmp, IntHash, 0);
+	for (i = 0; i < RANDOM_KEYS; i++)
+	{
+		values[i] = i;
+	}
+	for (i = 0; i < 100000; i++)
+	{
+		key = rand() % RANDOM_KEYS;
+		if (rand() % 2 && !present[key])
+		{
+			assert(OpenHashInsert(ht, &values[key]) == 0);
+			present[key] = 1;
+			++count;
+		}
+		else if (present[key])
+		{
+			OpenHashRemove(ht, &values[key]);
+			present[key] = 0;
+			--count;
+		}
+	}
+	assert(OpenHashSize(ht) == count);
+	for (key = 0; key < RANDOM_KEYS; key++)
+	{
+		assert((OpenHashFind(ht, &values[key]) != NULL) == present[key]);
+	}
+
+	OpenHashDestroy(ht);
+	printf("Random tests passed!\n\n");
+}
+
+void TestCollisions()
+{
+	static int values[600];
+	open_hash_table_t* ht = NULL;
+	int same_value = 42;
+	int i = 0;
+
+	printf("Testing collisions and duplicates...\n");
+
+	/* Probes longer than a distance byte holds */
+	ht = OpenHashCreate(IntCmp, ConstHash, 1);
+	for (i = 0; i < 600; i++)
+	{
+		values[i] = i;
+		assert(OpenHashInsert(ht, &values[i]) == 0);
+	}
+	for (i = 0; i < 600; i++)
+	{
+		assert(OpenHashFind(ht, &values[i]) == &values[i]);
+	}
+	for (i = 0; i < 600; i += 3)
+	{
+		OpenHashRemove(ht, &values[i]);
+	}
+	for (i = 0; i < 600; i++)
+	{
+		assert((OpenHashFind(ht, &values[i]) != NULL) == (i % 3 != 0));
+	}
+	assert(OpenHashSize(ht) == 400);
+	OpenHashDestroy(ht);
+
+	/* Duplicates are allowed, as in the chained table */
+	ht = OpenHashCreate(IntCmp, IntHash, TEST_SIZE);
+	for (i = 0; i < 3; i++)
+	{
+		OpenHashInsert(ht, &same_value);
+	}
+	assert(OpenHashSize(ht) == 3);
+	OpenHashRemove(ht, &same_value);
+	assert(OpenHashSize(ht) == 2 && OpenHashFind(ht, &same_value));
+	OpenHashDestroy(ht);
+
+	printf("Collision tests passed!\n\n");
+}
+
+void TestCachedHash()
+{
+	static int values[RANDOM_KEYS];
+	open_hash_table_t* ht = NULL;
+	int missing = -1;
+	int i = 0;
+
+	printf("Testing cached hashes...\n");
+
+	/* Growth from 8 slots reuses the stored hashes */
+	ht = OpenHashCreate(CountingIntCmp, CountingIntHash, 1);
+	for (i = 0; i < RANDOM_KEYS; i++)
+	{
+		values[i] = i;
+		OpenHashInsert(ht, &values[i]);
+	}
+	assert(hash_calls == RANDOM_KEYS);
+
+	/* Keys only get compared on a hash match */
+	cmp_calls = 0;
+	for (i = 0; i < RANDOM_KEYS; i++)
+	{
+		assert(OpenHashFind(ht, &values[i]) == &values[i]);
+	}
+	assert(OpenHashFind(ht, &missing) == NULL);
+	assert(cmp_calls == RANDOM_KEYS);
+
+	OpenHashDestroy(ht);
+	printf("Cached hash tests passed!\n\n");
+}
+
+void TestStrings()
+{
+	char* words[] = {"hello", "world", "hash", "table", "test"};
+	open_hash_table_t* ht = NULL;
+	int i = 0;
+
+	printf("Testing with string data...\n");
+
+	ht = OpenHashCreate(StrCmp, StrHash, TEST_SIZE);
+	for (i = 0; i < 5; i++)
+	{
+		OpenHashInsert(ht, words[i]);
+	}
+	for (i = 0; i < 5; i++)
+	{
+		assert(strcmp((char*) OpenHashFind(ht, words[i]), words[i]) == 0);
+	}
+	assert(OpenHashFind(ht, "nonexistent") == NULL);
+
+	OpenHashDestroy(ht);
+	printf("String tests passed!\n\n");
+}
+
+/*================================= MAIN ==================================*/
+
+int main()
+{
+	printf("========== OPEN HASH TABLE TESTS ==========\n\n");
+
+	TestBasic();
+	TestGrowth();
+	TestRandom();
+	TestCollisions();
+	TestCachedHash();
+	TestStrings();
+
+	printf("========== ALL TESTS PASSED! ==========\n");
+	return 0;
+}